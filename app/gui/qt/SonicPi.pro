@@ -56,6 +56,8 @@ SOURCES += main.cpp \
            mainwindow.cpp \
            sonicpilexer.cpp \
            sonicpiapis.cpp \
+           sampleindexer.cpp \
+           helpsearch.cpp \
            sonicpiscintilla.cpp \
            oschandler.cpp \
            oscsender.cpp \
@@ -65,6 +67,8 @@ SOURCES += main.cpp \
            sonic_pi_tcp_osc_server.cpp \
            sonicpitheme.cpp \
            scope.cpp \
+           scope_dsp.cpp \
+           scope_spectrum.cpp \
            infowidget.cpp
 
 HEADERS  += mainwindow.h \
@@ -73,6 +77,8 @@ HEADERS  += mainwindow.h \
             sonicpilexer.h \
             sonicpilog.h \
             sonicpiapis.h \
+            sampleindexer.h \
+            helpsearch.h \
             sonicpiscintilla.h \
             oschandler.h \
             oscsender.h \
@@ -82,6 +88,8 @@ HEADERS  += mainwindow.h \
             ruby_help.h \
             sonicpitheme.h \
             scope.h \
+            scope_dsp.h \
+            scope_spectrum.h \
             infowidget.h
 
 TRANSLATIONS = lang/sonic-pi_bs.ts \
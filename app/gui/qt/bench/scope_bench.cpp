@@ -0,0 +1,63 @@
+//--
+// This file is part of Sonic Pi: http://sonic-pi.net
+// Full project source: https://github.com/samaaron/sonic-pi
+// License: https://github.com/samaaron/sonic-pi/blob/master/LICENSE.md
+//
+// Copyright 2013, 2014, 2015, 2016 by Sam Aaron (http://sam.aaron.name).
+// All rights reserved.
+//
+// Permission is granted for use, copying, modification, and
+// distribution of modified versions of this work as long as this
+// notice is included.
+//++
+
+// Times each scope downmix kernel available on this CPU over a block
+// of frames the size scsynth hands the scope, and checks that every
+// kernel agrees with the scalar one.
+
+#include "scope_dsp.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+int main(int argc, char *argv[])
+{
+  unsigned int frames = argc > 1 ? std::atoi(argv[1]) : 1024;
+  unsigned int iterations = argc > 2 ? std::atoi(argv[2]) : 20000;
+
+  std::vector<float> left(frames), right(frames);
+  for (unsigned int i = 0; i < frames; ++i) {
+    left[i] = std::sin(i * 0.01f);
+    right[i] = std::cos(i * 0.013f);
+  }
+
+  std::vector<double> ref_left(frames), ref_right(frames), ref_mono(frames);
+  std::vector<double> out_left(frames), out_right(frames), out_mono(frames);
+  std::vector<ScopeDownmixKernel> kernels = scopeDownmixKernels();
+  kernels.front().fn(left.data(), right.data(), ref_left.data(), ref_right.data(), ref_mono.data(), frames);
+
+  std::cout << "scope downmix: " << frames << " frames x " << iterations << " iterations"
+            << " (selected kernel: " << scopeDownmixKernel().name << ")" << std::endl;
+
+  for (const ScopeDownmixKernel& k : kernels) {
+    auto start = std::chrono::steady_clock::now();
+    for (unsigned int n = 0; n < iterations; ++n) {
+      k.fn(left.data(), right.data(), out_left.data(), out_right.data(), out_mono.data(), frames);
+    }
+    auto end = std::chrono::steady_clock::now();
+    double ns = std::chrono::duration<double, std::nano>(end - start).count() / iterations;
+
+    double err = 0;
+    for (unsigned int i = 0; i < frames; ++i) {
+      err = std::max(err, std::fabs(out_left[i] - ref_left[i]));
+      err = std::max(err, std::fabs(out_right[i] - ref_right[i]));
+      err = std::max(err, std::fabs(out_mono[i] - ref_mono[i]));
+    }
+
+    std::cout << "  " << k.name << ": " << ns << " ns/block, max error " << err << std::endl;
+  }
+  return 0;
+}
@@ -0,0 +1,28 @@
+#--
+# This file is part of Sonic Pi: http://sonic-pi.net
+# Full project source: https://github.com/samaaron/sonic-pi
+# License: https://github.com/samaaron/sonic-pi/blob/master/LICENSE.md
+#
+# Copyright 2013, 2014, 2015, 2016 by Sam Aaron (http://sam.aaron.name).
+# All rights reserved.
+#
+# Permission is granted for use, copying, modification, distribution,
+# and distribution of modified versions of this work as long as this
+# notice is included.
+#++
+
+# Micro-benchmark for the scope sample conversion kernels:
+#
+#   qmake scope_bench.pro && make && ./scope-bench [frames] [iterations]
+
+TARGET = 'scope-bench'
+TEMPLATE = app
+CONFIG += console c++11
+CONFIG -= qt app_bundle
+
+INCLUDEPATH += ..
+
+SOURCES += scope_bench.cpp \
+           ../scope_dsp.cpp
+
+HEADERS += ../scope_dsp.h
@@ -0,0 +1,212 @@
+//--
+// This file is part of Sonic Pi: http://sonic-pi.net
+// Full project source: https://github.com/samaaron/sonic-pi
+// License: https://github.com/samaaron/sonic-pi/blob/master/LICENSE.md
+//
+// Copyright 2013, 2014, 2015, 2016 by Sam Aaron (http://sam.aaron.name).
+// All rights reserved.
+//
+// Permission is granted for use, copying, modification, and
+// distribution of modified versions of this work as long as this
+// notice is included.
+//++
+
+#include <QResource>
+#include <QHash>
+#include <QtEndian>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+#include "helpsearch.h"
+
+static const quint32 HELP_SEARCH_VERSION = 1;
+static const quint32 HELP_SEARCH_HEADER_SIZE = 32;
+// a one letter prefix could match a large part of the vocabulary
+static const quint32 HELP_SEARCH_MAX_PREFIX_TERMS = 200;
+
+HelpSearchIndex::HelpSearchIndex(const QString &path)
+  : path(path), loaded(false), valid(false), data(0), size(0),
+    numDocs(0), numTerms(0), docsOffset(0), termsOffset(0), postingsOffset(0), stringsOffset(0)
+{
+}
+
+QStringList HelpSearchIndex::tokens(const QString &text)
+{
+  // must split words the same way as bin/qt-doc.rb
+  QStringList words;
+  QString lower = text.toLower();
+  int start = -1;
+  for (int i = 0; i <= lower.size(); i++) {
+    bool inWord = i < lower.size() && (lower[i].isLetterOrNumber() || lower[i] == '_');
+    if (inWord && start < 0) {
+      start = i;
+    } else if (!inWord && start >= 0) {
+      words << lower.mid(start, i - start);
+      start = -1;
+    }
+  }
+  return words;
+}
+
+quint32 HelpSearchIndex::word(quint32 offset) const
+{
+  return qFromLittleEndian<quint32>(data + offset);
+}
+
+QByteArray HelpSearchIndex::string(quint32 offset, quint32 len) const
+{
+  if ((quint64)stringsOffset + offset + len > size) return QByteArray();
+  return QByteArray::fromRawData((const char *)data + stringsOffset + offset, len);
+}
+
+bool HelpSearchIndex::load()
+{
+  loaded = true;
+  QResource res(path);
+  if (!res.isValid()) {
+    std::cout << "[GUI] - help search index not found: " << path.toStdString() << std::endl;
+    return false;
+  }
+
+  if (res.isCompressed()) {
+#if QT_VERSION >= 0x050F00
+    storage = res.uncompressedData();
+#else
+    storage = qUncompress(res.data(), res.size());
+#endif
+    data = (const uchar *)storage.constData();
+    size = storage.size();
+  } else {
+    // use the resource data where it is, no copy
+    data = res.data();
+    size = res.size();
+  }
+
+  if (size < HELP_SEARCH_HEADER_SIZE || std::memcmp(data, "SPHI", 4) != 0 || word(4) != HELP_SEARCH_VERSION) {
+    std::cout << "[GUI] - help search index is invalid" << std::endl;
+    return false;
+  }
+  numDocs = word(8);
+  numTerms = word(12);
+  docsOffset = word(16);
+  termsOffset = word(20);
+  postingsOffset = word(24);
+  stringsOffset = word(28);
+  if ((quint64)docsOffset + numDocs * 16ull > termsOffset ||
+      (quint64)termsOffset + numTerms * 16ull > postingsOffset ||
+      postingsOffset > stringsOffset || stringsOffset > size) {
+    std::cout << "[GUI] - help search index is invalid" << std::endl;
+    return false;
+  }
+
+  valid = true;
+  return true;
+}
+
+void HelpSearchIndex::findTerms(const QByteArray &term, bool prefix, quint32 &begin, quint32 &end) const
+{
+  // compare the term at idx with ours, bytewise as qt-doc.rb sorts them
+  auto compare = [this, &term](quint32 idx) -> int {
+    quint32 entry = termsOffset + idx * 16;
+    QByteArray t = string(word(entry), word(entry + 4));
+    int r = std::memcmp(t.constData(), term.constData(), std::min(t.size(), term.size()));
+    if (r != 0) return r;
+    return t.size() - term.size();
+  };
+
+  quint32 lo = 0, hi = numTerms;
+  while (lo < hi) {
+    quint32 mid = lo + (hi - lo) / 2;
+    if (compare(mid) < 0) lo = mid + 1; else hi = mid;
+  }
+  begin = lo;
+  end = lo;
+  if (!prefix) {
+    if (end < numTerms && compare(end) == 0) end++;
+    return;
+  }
+  while (end < numTerms && end - begin < HELP_SEARCH_MAX_PREFIX_TERMS) {
+    quint32 entry = termsOffset + end * 16;
+    if (!string(word(entry), word(entry + 4)).startsWith(term)) break;
+    end++;
+  }
+}
+
+QList<HelpSearchIndex::Result> HelpSearchIndex::search(const QString &query, int max, const QSet<QString> &urls)
+{
+  QList<Result> results;
+  QStringList words = tokens(query);
+  if (words.isEmpty()) return results;
+  if (!loaded) load();
+  if (!valid) return results;
+
+  // only complete the last word while it is still being typed
+  QChar last = query[query.size() - 1];
+  bool completing = last.isLetterOrNumber() || last == '_';
+
+  QHash<quint32, double> scores;
+  for (int w = 0; w < words.size(); w++) {
+    quint32 begin, end;
+    findTerms(words[w].toUtf8(), completing && w == words.size() - 1, begin, end);
+
+    // score each page by the best matching term, tf-idf style
+    QHash<quint32, double> wordScores;
+    for (quint32 t = begin; t < end; t++) {
+      quint32 entry = termsOffset + t * 16;
+      quint32 first = word(entry + 8);
+      quint32 count = word(entry + 12);
+      if ((quint64)postingsOffset + ((quint64)first + count) * 12 > stringsOffset) continue;
+      double idf = std::log(1.0 + (double)numDocs / count);
+      for (quint32 p = first; p < first + count; p++) {
+        quint32 posting = postingsOffset + p * 12;
+        quint32 doc = word(posting);
+        quint32 tf = word(posting + 4);
+        quint32 pos = word(posting + 8);
+        // slightly prefer pages which mention the word early on
+        double s = (1.0 + std::log((double)tf)) * idf + 0.5 / (1.0 + pos);
+        if (s > wordScores.value(doc, 0)) wordScores[doc] = s;
+      }
+    }
+
+    if (w == 0) {
+      scores = wordScores;
+    } else {
+      // pages must contain every word
+      for (QHash<quint32, double>::iterator it = scores.begin(); it != scores.end(); ) {
+        if (wordScores.contains(it.key())) {
+          it.value() += wordScores[it.key()];
+          ++it;
+        } else {
+          it = scores.erase(it);
+        }
+      }
+    }
+    if (scores.isEmpty()) return results;
+  }
+
+  // filter before ranking so pages we can't offer don't take up any
+  // of the max places
+  QList<QPair<double, quint32> > ranked;
+  for (QHash<quint32, double>::const_iterator it = scores.constBegin(); it != scores.constEnd(); ++it) {
+    if (it.key() >= numDocs) continue;
+    if (!urls.isEmpty()) {
+      quint32 entry = docsOffset + it.key() * 16;
+      if (!urls.contains(QString::fromUtf8(string(word(entry + 8), word(entry + 12))))) continue;
+    }
+    ranked << qMakePair(-it.value(), it.key());
+  }
+  std::sort(ranked.begin(), ranked.end());
+
+  for (int i = 0; i < ranked.size() && i < max; i++) {
+    quint32 entry = docsOffset + ranked[i].second * 16;
+    Result r;
+    r.title = QString::fromUtf8(string(word(entry), word(entry + 4)));
+    r.url = QString::fromUtf8(string(word(entry + 8), word(entry + 12)));
+    r.score = -ranked[i].first;
+    results << r;
+  }
+  return results;
+}
@@ -0,0 +1,64 @@
+//--
+// This file is part of Sonic Pi: http://sonic-pi.net
+// Full project source: https://github.com/samaaron/sonic-pi
+// License: https://github.com/samaaron/sonic-pi/blob/master/LICENSE.md
+//
+// Copyright 2013, 2014, 2015, 2016 by Sam Aaron (http://sam.aaron.name).
+// All rights reserved.
+//
+// Permission is granted for use, copying, modification, and
+// distribution of modified versions of this work as long as this
+// notice is included.
+//++
+
+#ifndef HELPSEARCH_H
+#define HELPSEARCH_H
+
+#include <QByteArray>
+#include <QString>
+#include <QStringList>
+#include <QList>
+#include <QSet>
+
+// Full text search over the help pages using the inverted index which
+// bin/qt-doc.rb writes to help/search.idx (see there for the layout).
+// The index is read in place from the resource data, and only once the
+// first search is made.
+class HelpSearchIndex
+{
+public:
+  struct Result {
+    QString title;
+    QString url;
+    double score;
+  };
+
+  HelpSearchIndex(const QString &path);
+
+  // Pages containing every word of the query, the last word being
+  // matched as a prefix so results can follow typing, best first.
+  // Only pages whose url is in urls are considered, unless it is empty.
+  QList<Result> search(const QString &query, int max, const QSet<QString> &urls = QSet<QString>());
+
+  static QStringList tokens(const QString &text);
+
+private:
+  struct Posting {
+    quint32 doc, tf, first;
+  };
+
+  bool load();
+  quint32 word(quint32 offset) const;
+  QByteArray string(quint32 offset, quint32 len) const;
+  // the range of terms equal to, or starting with, the given term
+  void findTerms(const QByteArray &term, bool prefix, quint32 &begin, quint32 &end) const;
+
+  QString path;
+  bool loaded, valid;
+  QByteArray storage;
+  const uchar *data;
+  quint32 size;
+  quint32 numDocs, numTerms, docsOffset, termsOffset, postingsOffset, stringsOffset;
+};
+
+#endif
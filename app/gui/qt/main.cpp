@@ -20,7 +20,6 @@
 #include <QLibraryInfo>
 
 #include "mainwindow.h"
-#include "sonicpilog.h"
 int main(int argc, char *argv[])
 {
 #ifndef Q_OS_MAC
@@ -32,8 +31,6 @@ int main(int argc, char *argv[])
   QFontDatabase::addApplicationFont(":/fonts/Hack-Regular.ttf");
   QFontDatabase::addApplicationFont(":/fonts/Hack-Italic.ttf");
 
-  qRegisterMetaType<SonicPiLog::MultiMessage>("SonicPiLog::MultiMessage");
-
   QString systemLocale = QLocale::system().name();
 
   QTranslator qtTranslator;
@@ -48,6 +48,9 @@
 #include <QTextBrowser>
 #include <QToolBar>
 #include <QProcess>
+#include <QElapsedTimer>
+#include <QThread>
+#include <QCryptographicHash>
 #include <QFont>
 #include <QTabWidget>
 #include <QString>
@@ -69,6 +72,7 @@
 #include <QSignalMapper>
 #include <QSplitter>
 #include <QComboBox>
+#include <QLineEdit>
 
 // QScintilla stuff
 #include <Qsci/qsciapis.h>
@@ -76,6 +80,8 @@
 
 #include "sonicpilexer.h"
 #include "sonicpiapis.h"
+#include "sampleindexer.h"
+#include "helpsearch.h"
 #include "sonicpiscintilla.h"
 #include "sonicpitheme.h"
 
@@ -103,6 +109,13 @@ using namespace oscpkt;// OSC specific stuff
   #include <QtConcurrentRun>
 #endif
 
+// how long to wait for each stage of the server boot handshake, and how
+// often to check on it (ms)
+static const int SERVER_BOOT_TIMEOUT = 60000;
+static const int SERVER_POLL_INTERVAL = 50;
+// buffers at least this big are sent as changed lines on later runs
+static const size_t RUN_DELTA_MIN_SIZE = 8192;
+
 
 #if QT_VERSION >= 0x050400
 // Requires Qt5
@@ -117,8 +130,8 @@ MainWindow::MainWindow(QApplication &app, bool i18n, QMainWindow* splash)
 MainWindow::MainWindow(QApplication &app, bool i18n, QSplashScreen* splash)
 #endif
 {
-
-
+  QElapsedTimer startup_timer;
+  startup_timer.start();
 
   QString root_path = rootPath();
 
@@ -159,6 +172,9 @@ MainWindow::MainWindow(QApplication &app, bool i18n, QSplashScreen* splash)
 
   QDir logDir(log_path);
   logDir.mkpath(logDir.absolutePath());
+  // like the other logs, the saved log pane lines only cover one session
+  QFile::remove(QDir::toNativeSeparators(log_path + "/output-pane.log"));
+  QFile::remove(QDir::toNativeSeparators(log_path + "/cues-pane.log"));
 
   QFile tmpFile(sp_user_tmp_path);
   if (!tmpFile.open(QIODevice::WriteOnly)) {
@@ -194,13 +210,23 @@ MainWindow::MainWindow(QApplication &app, bool i18n, QSplashScreen* splash)
   }
 
 
-  QProcess* determineSendPortNumber = new QProcess();
-  QStringList send_args;
-  send_args << port_discovery_path << "gui-send-to-server";
+  // Discover every port with a single Ruby process, starting one per
+  // port used to cost several seconds of boot time on a Raspberry Pi
+  QProcess* determinePortNumbers = new QProcess();
+  QStringList port_discovery_args;
+  port_discovery_args << port_discovery_path << "all";
 
-  determineSendPortNumber->start(ruby_path, send_args);
-  determineSendPortNumber->waitForFinished();
-  gui_send_to_server_port = determineSendPortNumber->readAllStandardOutput().trimmed().toInt();
+  determinePortNumbers->start(ruby_path, port_discovery_args);
+  determinePortNumbers->waitForFinished();
+  QHash<QString, int> ports;
+  foreach (const QString &line, QString(determinePortNumbers->readAllStandardOutput()).split('\n', QString::SkipEmptyParts)) {
+    QStringList port_info = line.split(':');
+    if (port_info.size() == 2) {
+      ports[port_info[0].trimmed()] = port_info[1].trimmed().toInt();
+    }
+  }
+
+  gui_send_to_server_port = ports.value("gui-send-to-server", 0);
 
   if (gui_send_to_server_port == 0) {
     std::cout << "[GUI] - unable to determine GUI->Server send port. Defaulting to 4557:" << std::endl;
@@ -209,117 +235,62 @@ MainWindow::MainWindow(QApplication &app, bool i18n, QSplashScreen* splash)
 
   oscSender = new OscSender(gui_send_to_server_port);
 
-  QProcess* determineListenPortNumber = new QProcess();
-  QStringList listen_args;
-  listen_args << port_discovery_path << "gui-listen-to-server";
-
-  determineListenPortNumber->start(ruby_path, listen_args);
-  determineListenPortNumber->waitForFinished();
-  gui_listen_to_server_port = determineListenPortNumber->readAllStandardOutput().trimmed().toInt();
+  gui_listen_to_server_port = ports.value("gui-listen-to-server", 0);
   if (gui_listen_to_server_port == 0) {
     std::cout << "[GUI] - unable to determine GUI<-Server listen port. Defaulting to 4558:" << std::endl;
     gui_listen_to_server_port = 4558;
   }
 
-  QProcess* determineServerListenPortNumber = new QProcess();
-  QStringList server_listen_args;
-  server_listen_args << port_discovery_path << "server-listen-to-gui";
-
-  determineServerListenPortNumber->start(ruby_path, server_listen_args);
-  determineServerListenPortNumber->waitForFinished();
-  server_listen_to_gui_port = determineServerListenPortNumber->readAllStandardOutput().trimmed().toInt();
+  server_listen_to_gui_port = ports.value("server-listen-to-gui", 0);
   if (server_listen_to_gui_port == 0) {
     std::cout << "[GUI] - unable to determine Server<-GUI listen port. Defaulting to 4557:" << std::endl;
     server_listen_to_gui_port = 4557;
   }
 
-  QProcess* determineServerOSCCuesPortNumber = new QProcess();
-  QStringList server_osc_cue_args;
-  server_osc_cue_args << port_discovery_path << "server-osc-cues";
-
-  determineServerOSCCuesPortNumber->start(ruby_path, server_osc_cue_args);
-  determineServerOSCCuesPortNumber->waitForFinished();
-  server_osc_cues_port = determineServerOSCCuesPortNumber->readAllStandardOutput().trimmed().toInt();
+  server_osc_cues_port = ports.value("server-osc-cues", 0);
   if (server_osc_cues_port == 0) {
     std::cout << "[GUI] - unable to determine Server OSC cue listen port. Defaulting to 4559:" << std::endl;
     server_osc_cues_port = 4559;
   }
 
-  QProcess* determineServerSendPortNumber = new QProcess();
-  QStringList server_send_args;
-  server_send_args << port_discovery_path << "server-send-to-gui";
-
-  determineServerSendPortNumber->start(ruby_path, server_send_args);
-  determineServerSendPortNumber->waitForFinished();
-  server_send_to_gui_port = determineServerSendPortNumber->readAllStandardOutput().trimmed().toInt();
+  server_send_to_gui_port = ports.value("server-send-to-gui", 0);
   if (server_send_to_gui_port == 0) {
     std::cout << "[GUI] - unable to determine Server->GUI send port. Defaulting to 4558:" << std::endl;
     server_send_to_gui_port = 4558;
   }
 
-  QProcess* determineScsynthPortNumber = new QProcess();
-  QStringList scsynth_args;
-  scsynth_args << port_discovery_path << "scsynth";
-
-  determineScsynthPortNumber->start(ruby_path, scsynth_args);
-  determineScsynthPortNumber->waitForFinished();
-  scsynth_port = determineScsynthPortNumber->readAllStandardOutput().trimmed().toInt();
+  scsynth_port = ports.value("scsynth", 0);
   if (scsynth_port == 0) {
     std::cout << "[GUI] - unable to determine scsynth port. Defaulting to 4556:" << std::endl;
     scsynth_port = 4556;
   }
 
-  QProcess* determineScsynthSendPortNumber = new QProcess();
-  QStringList scsynth_send_args;
-  scsynth_send_args << port_discovery_path << "scsynth-send";
-
-  determineScsynthSendPortNumber->start(ruby_path, scsynth_send_args);
-  determineScsynthSendPortNumber->waitForFinished();
-  scsynth_send_port = determineScsynthSendPortNumber->readAllStandardOutput().trimmed().toInt();
+  scsynth_send_port = ports.value("scsynth-send", 0);
   if (scsynth_send_port == 0) {
     std::cout << "[GUI] - unable to determine scsynth send port. Defaulting to 4556:" << std::endl;
     scsynth_send_port = 4556;
   }
 
-  QProcess* determineErlangRouterPortNumber = new QProcess();
-  QStringList erlang_router_args;
-  erlang_router_args << port_discovery_path << "erlang-router";
-
-  determineErlangRouterPortNumber->start(ruby_path, erlang_router_args);
-  determineErlangRouterPortNumber->waitForFinished();
-  erlang_router_port = determineErlangRouterPortNumber->readAllStandardOutput().trimmed().toInt();
+  erlang_router_port = ports.value("erlang-router", 0);
   if (erlang_router_port == 0) {
     std::cout << "[GUI] - unable to determine Erlang router port. Defaulting to 4560:" << std::endl;
     erlang_router_port = 4560;
   }
 
-
-  QProcess* determineOscMidiOutPortNumber = new QProcess();
-  QStringList osc_midi_out_args;
-  osc_midi_out_args << port_discovery_path << "osc-midi-out";
-
-  determineOscMidiOutPortNumber->start(ruby_path, osc_midi_out_args);
-  determineOscMidiOutPortNumber->waitForFinished();
-  osc_midi_out_port = determineOscMidiOutPortNumber->readAllStandardOutput().trimmed().toInt();
+  osc_midi_out_port = ports.value("osc-midi-out", 0);
   if (osc_midi_out_port == 0) {
     std::cout << "[GUI] - unable to determine OSC MIDI out port. Defaulting to 4561:" << std::endl;
     osc_midi_out_port = 4561;
   }
 
-
-  QProcess* determineOscMidiInPortNumber = new QProcess();
-  QStringList osc_midi_in_args;
-  osc_midi_in_args << port_discovery_path << "osc-midi-in";
-
-  determineOscMidiInPortNumber->start(ruby_path, osc_midi_in_args);
-  determineOscMidiInPortNumber->waitForFinished();
-  osc_midi_in_port = determineOscMidiInPortNumber->readAllStandardOutput().trimmed().toInt();
+  osc_midi_in_port = ports.value("osc-midi-in", 0);
   if (osc_midi_in_port == 0) {
     std::cout << "[GUI] - unable to determine OSC MIDI in port. Defaulting to 4562:" << std::endl;
     osc_midi_in_port = 4562;
   }
 
-  printAsciiArtLogo();
+  // the logo is only for the log, so don't hold up startup reading it
+  QTimer::singleShot(0, this, SLOT(printAsciiArtLogo()));
 
   // Clear out old tasks from previous sessions if they still exist
   QProcess *initProcess = new QProcess();
@@ -352,32 +323,6 @@ MainWindow::MainWindow(QApplication &app, bool i18n, QSplashScreen* splash)
   setupTheme();
   lexer = new SonicPiLexer(theme);
 
-  // load up pro icons into memory
-  pro_run_icon = QIcon(":/images/toolbar/pro/run.png");
-  pro_stop_icon = QIcon(":/images/toolbar/pro/stop.png");
-  pro_save_icon = QIcon(":/images/toolbar/pro/save.png");
-  pro_load_icon = QIcon(":/images/toolbar/pro/load.png");
-  pro_rec_icon = QIcon(":/images/toolbar/pro/rec.png");
-  pro_size_up_icon = QIcon(":/images/toolbar/pro/size-up.png");
-  pro_size_down_icon = QIcon(":/images/toolbar/pro/size-down.png");
-  pro_scope_bordered_icon = QIcon(":/images/toolbar/pro/scope-bordered.png");
-  pro_scope_icon = QIcon(":/images/toolbar/pro/scope.png");
-  pro_info_icon = QIcon(":/images/toolbar/pro/info.png");
-  pro_info_bordered_icon = QIcon(":/images/toolbar/pro/info-bordered.png");
-  pro_help_bordered_icon = QIcon(":/images/toolbar/pro/help-bordered.png");
-  pro_help_icon = QIcon(":/images/toolbar/pro/help.png");
-  pro_prefs_icon = QIcon(":/images/toolbar/pro/prefs.png");
-  pro_prefs_bordered_icon = QIcon(":/images/toolbar/pro/prefs-bordered.png");
-  pro_info_dark_bordered_icon = QIcon(":/images/toolbar/pro/info-dark-bordered.png");
-  pro_info_dark_icon = QIcon(":/images/toolbar/pro/info-dark.png");
-  pro_help_dark_bordered_icon = QIcon(":/images/toolbar/pro/help-dark-bordered.png");
-  pro_help_dark_icon = QIcon(":/images/toolbar/pro/help-dark.png");
-  pro_prefs_dark_bordered_icon = QIcon(":/images/toolbar/pro/prefs-dark-bordered.png");
-  pro_prefs_dark_icon = QIcon(":/images/toolbar/pro/prefs-dark.png");
-  pro_rec_b_icon = QIcon(":/images/toolbar/pro/recording-b.png");
-  pro_rec_b_dark_icon = QIcon(":/images/toolbar/pro/recording-b-dark.png");
-  pro_load_dark_icon = QIcon(":/images/toolbar/pro/load-dark.png");
-  pro_save_dark_icon = QIcon(":/images/toolbar/pro/save-dark.png");
 
   setupWindowStructure();
   createShortcuts();
@@ -396,8 +341,14 @@ MainWindow::MainWindow(QApplication &app, bool i18n, QSplashScreen* splash)
   // be found in ruby_help.h:
   initDocsWindow();
 
-  //setup autocompletion
-  autocomplete->loadSamples(sample_path);
+  //setup autocompletion - samples are found in the background
+  sampleIndexer = new SampleIndexer(this);
+  connect(sampleIndexer, SIGNAL(samplesAdded(QStringList)), this, SLOT(addSampleNames(QStringList)));
+  connect(sampleIndexer, SIGNAL(samplesRemoved(QStringList)), this, SLOT(removeSampleNames(QStringList)));
+  sampleIndexer->addFolder(sample_path, true);
+  for (int i = 0; i < sample_folders_list->count(); i++) {
+    sampleIndexer->addFolder(sample_folders_list->item(i)->text(), false);
+  }
 
   OscHandler* handler = new OscHandler(this, outputPane, errorPane, incomingPane, theme);
 
@@ -428,6 +379,7 @@ MainWindow::MainWindow(QApplication &app, bool i18n, QSplashScreen* splash)
     updateFullScreenMode();
     showWelcomeScreen();
     changeSystemPreAmp(system_vol_slider->value(), 1);
+    std::cout << "[GUI] - startup took " << startup_timer.elapsed() << "ms" << std::endl;
     connect(&app, SIGNAL( aboutToQuit() ), this, SLOT( onExitCleanup() ) );
     QTimer *timer = new QTimer(this);
     connect(timer, SIGNAL(timeout()), this, SLOT(heartbeatOSC()));
@@ -651,8 +603,7 @@ void MainWindow::setupWindowStructure() {
       incomingPane->setFontFamily(theme->font("LogFace"));
   }
 
-  outputPane->document()->setMaximumBlockCount(1000);
-  incomingPane->document()->setMaximumBlockCount(1000);
+  // the log panes bound themselves, see updateLogLimits()
   errorPane->document()->setMaximumBlockCount(1000);
 
   outputPane->setTextColor(QColor(theme->color("LogInfoForeground")));
@@ -679,7 +630,17 @@ void MainWindow::setupWindowStructure() {
   scopeWidget->setFocusPolicy(Qt::NoFocus);
   scopeWidget->setAllowedAreas(Qt::RightDockWidgetArea | Qt::BottomDockWidgetArea | Qt::TopDockWidgetArea);
   scopeWidget->setFeatures(QDockWidget::DockWidgetClosable | QDockWidget::DockWidgetMovable | QDockWidget::DockWidgetFloatable);
-  scopeInterface = new Scope();
+  // prefs/scope/buffers lists the scsynth scope buffers to show, e.g.
+  // "0,1,2". The first drives the standard panels and each of the rest
+  // gets a panel of its own.
+  std::vector<unsigned int> scopeBuffers;
+  QSettings scopeSettings("sonic-pi.net", "gui-settings");
+  foreach (const QString &buf, scopeSettings.value("prefs/scope/buffers", "0").toString().split(",", QString::SkipEmptyParts)) {
+    bool ok;
+    unsigned int idx = buf.trimmed().toUInt(&ok);
+    if (ok) scopeBuffers.push_back(idx);
+  }
+  scopeInterface = new Scope(scsynth_port, scopeBuffers);
   scopeInterface->pause();
   scopeWidget->setWidget(scopeInterface);
   scopeWidget->setObjectName("scope");
@@ -727,6 +688,7 @@ void MainWindow::setupWindowStructure() {
   docsCentral->setTabsClosable(false);
   docsCentral->setMovable(false);
   docsCentral->setTabPosition(QTabWidget::South);
+  connect(docsCentral, SIGNAL(currentChanged(int)), this, SLOT(populateHelpTab(int)));
 
   docPane = new QTextBrowser;
   QSizePolicy policy = docPane->sizePolicy();
@@ -748,7 +710,30 @@ void MainWindow::setupWindowStructure() {
 
   docsplit = new QSplitter;
 
-  docsplit->addWidget(docsCentral);
+  // searching the help swaps the tabs for a list of the best matches
+  helpSearch = new HelpSearchIndex(":/help/search.idx");
+  helpSearchBox = new QLineEdit;
+  helpSearchBox->setPlaceholderText(tr("Search help"));
+  helpSearchBox->setToolTip(tr("Search the text of the tutorial and reference."));
+  connect(helpSearchBox, SIGNAL(textChanged(const QString&)), this, SLOT(searchHelp(const QString&)));
+  helpSearchResults = new QListWidget;
+  helpSearchResults->hide();
+  connect(helpSearchResults,
+	  SIGNAL(itemPressed(QListWidgetItem*)),
+	  this, SLOT(updateDocPane(QListWidgetItem*)));
+  connect(helpSearchResults,
+	  SIGNAL(currentItemChanged(QListWidgetItem*, QListWidgetItem*)),
+	  this, SLOT(updateDocPane2(QListWidgetItem*, QListWidgetItem*)));
+
+  QVBoxLayout *helpNavLayout = new QVBoxLayout;
+  helpNavLayout->setContentsMargins(0, 0, 0, 0);
+  helpNavLayout->addWidget(helpSearchBox);
+  helpNavLayout->addWidget(docsCentral);
+  helpNavLayout->addWidget(helpSearchResults);
+  QWidget *helpNav = new QWidget;
+  helpNav->setLayout(helpNavLayout);
+
+  docsplit->addWidget(helpNav);
   docsplit->addWidget(docPane);
 
   docWidget = new QDockWidget(tr("Help"), this);
@@ -1058,52 +1043,43 @@ void MainWindow::startRubyServer(){
 }
 
 bool MainWindow::waitForServiceSync() {
-  QString contents;
   std::cout << "[GUI] - waiting for Sonic Pi Server to boot..." << std::endl;
-  bool server_booted = false;
-  if (!homeDirWritable) {
-    // we can't monitor the logs so hope for the best!
-    sleep(15);
-    server_booted = true;
-  } else {
-    for(int i = 0; i < 60; i ++) {
-      qApp->processEvents();
-      contents = readFile(server_output_log_path);
-      if (contents.contains("Sonic Pi Server successfully booted.")) {
-        std::cout << std::endl << "[GUI] - Sonic Pi Server successfully booted." << std::endl;
-        server_booted = true;
-        break;
-      } else {
-        std::cout << ".";
-        sleep(1);
-      }
-    }
+  // The server reports each boot phase (scsynth, synthdefs, erlang and
+  // finally ready) to the GUI OSC port as it completes, so there is no
+  // need to watch its log file.
+  QElapsedTimer boot_timer;
+  boot_timer.start();
+  while (sonicPiOSCServer->waitForBoot() && boot_timer.elapsed() < SERVER_BOOT_TIMEOUT) {
+    qApp->processEvents();
+    QThread::msleep(SERVER_POLL_INTERVAL);
   }
 
-  if (!server_booted) {
+  if (!sonicPiOSCServer->isServerBooted()) {
       std::cout << std::endl << "[GUI] - Critical error! Could not boot Sonic Pi Server." << std::endl;
       invokeStartupError("Critical error! - Could not boot Sonic Pi Server.");
       return false;
   }
+  std::cout << "[GUI] - Sonic Pi Server successfully booted." << std::endl;
 
-  int timeout = 60;
   std::cout << "[GUI] - waiting for Sonic Pi Server to respond..." << std::endl;
-  while (sonicPiOSCServer->waitForServer() && timeout-- > 0) {
-    sleep(1);
-    std::cout << ".";
-    if(sonicPiOSCServer->isIncomingPortOpen()) {
+  QElapsedTimer ping_timer;
+  boot_timer.restart();
+  while (sonicPiOSCServer->waitForServer() && boot_timer.elapsed() < SERVER_BOOT_TIMEOUT) {
+    if(sonicPiOSCServer->isIncomingPortOpen() && (!ping_timer.isValid() || ping_timer.elapsed() >= 1000)) {
+      ping_timer.start();
       Message msg("/ping");
       msg.pushStr(guiID.toStdString());
       msg.pushStr("QtClient/1/hello");
       sendOSC(msg);
     }
+    QThread::msleep(SERVER_POLL_INTERVAL);
   }
   if (!sonicPiOSCServer->isServerStarted()) {
       std::cout << std::endl <<  "[GUI] - Critical error! Could not connect to Sonic Pi Server." << std::endl;
       invokeStartupError("Critical server error - could not connect to Sonic Pi Server!");
       return false;
   } else {
-    std::cout << std::endl << "[GUI] - Sonic Pi Server connection established" << std::endl;
+    std::cout << "[GUI] - Sonic Pi Server connection established" << std::endl;
     return true;
   }
 
@@ -1172,6 +1148,7 @@ void MainWindow::honourPrefs() {
   changeSystemPreAmp(stored_vol, 1);
   update_check_updates();
   updateLogAutoScroll();
+  updateLogLimits();
   toggleScopeAxes();
   toggleMidi(1);
   toggleOSCServer(1);
@@ -1360,6 +1337,19 @@ void MainWindow::initPrefsWindow() {
   log_auto_scroll->setToolTip(tr("Toggle log auto scrolling.\nIf enabled the log is scrolled to the bottom after every new message is displayed."));
   connect(log_auto_scroll, SIGNAL(clicked()), this, SLOT(updateLogAutoScroll()));
 
+  log_max_lines_combo = new QComboBox();
+  log_max_lines_combo->addItem("1000", 1000);
+  log_max_lines_combo->addItem("5000", 5000);
+  log_max_lines_combo->addItem("20000", 20000);
+  log_max_lines_combo->addItem("100000", 100000);
+  log_max_lines_combo->setToolTip(tr("The number of lines each log keeps.\nOlder lines are removed to keep Sonic Pi responsive during long sessions."));
+  connect(log_max_lines_combo, SIGNAL(currentIndexChanged(int)), this, SLOT(updateLogLimits()));
+  QLabel *log_max_lines_label = new QLabel(tr("Log lines"));
+
+  log_spill = new QCheckBox(tr("Save old log lines"));
+  log_spill->setToolTip(tr("Toggle saving of old log lines.\nIf enabled, lines removed from the logs are written to\n~/.sonic-pi/log/output-pane.log and ~/.sonic-pi/log/cues-pane.log."));
+  connect(log_spill, SIGNAL(clicked()), this, SLOT(updateLogLimits()));
+
   check_args = new QCheckBox(tr("Safe mode"));
   check_args->setToolTip(tr("Toggle synth argument checking functions.\nIf disabled, certain synth opt values may\ncreate unexpectedly loud or uncomfortable sounds."));
 
@@ -1375,6 +1365,11 @@ void MainWindow::initPrefsWindow() {
   debug_box_layout->addWidget(log_cues);
   debug_box_layout->addWidget(log_auto_scroll);
   debug_box_layout->addWidget(clear_output_on_run);
+  QHBoxLayout *log_max_lines_layout = new QHBoxLayout;
+  log_max_lines_layout->addWidget(log_max_lines_label);
+  log_max_lines_layout->addWidget(log_max_lines_combo);
+  debug_box_layout->addLayout(log_max_lines_layout);
+  debug_box_layout->addWidget(log_spill);
   debug_box->setLayout(debug_box_layout);
 
   QVBoxLayout *synths_box_layout = new QVBoxLayout;
@@ -1487,6 +1482,20 @@ void MainWindow::initPrefsWindow() {
   gridEditorPrefs->addWidget(automation_box, 1, 1);
   gridEditorPrefs->addWidget(debug_box, 1, 0);
 
+  QGroupBox *sample_folders_box = new QGroupBox(tr("Sample Folders"));
+  sample_folders_box->setToolTip(tr("Folders of your own samples to offer when autocompleting sample names.\nSubfolders are included."));
+  sample_folders_list = new QListWidget;
+  QPushButton *add_sample_folder_button = new QPushButton(tr("Add..."));
+  QPushButton *remove_sample_folder_button = new QPushButton(tr("Remove"));
+  connect(add_sample_folder_button, SIGNAL(clicked()), this, SLOT(addSampleFolder()));
+  connect(remove_sample_folder_button, SIGNAL(clicked()), this, SLOT(removeSampleFolder()));
+  QGridLayout *sample_folders_layout = new QGridLayout;
+  sample_folders_layout->addWidget(sample_folders_list, 0, 0, 2, 1);
+  sample_folders_layout->addWidget(add_sample_folder_button, 0, 1);
+  sample_folders_layout->addWidget(remove_sample_folder_button, 1, 1);
+  sample_folders_box->setLayout(sample_folders_layout);
+  gridEditorPrefs->addWidget(sample_folders_box, 2, 0, 1, 2);
+
   editor_box->setLayout(gridEditorPrefs);
   grid->addWidget(prefTabs, 0, 0);
 
@@ -1594,6 +1603,10 @@ void MainWindow::initPrefsWindow() {
   clear_output_on_run->setChecked(settings.value("prefs/clear-output-on-run", true).toBool());
   log_cues->setChecked(settings.value("prefs/log-cues", false).toBool());
   log_auto_scroll->setChecked(settings.value("prefs/log-auto-scroll", true).toBool());
+  int log_max_lines_idx = log_max_lines_combo->findData(settings.value("prefs/log-max-lines", 1000).toInt());
+  log_max_lines_combo->setCurrentIndex(log_max_lines_idx < 0 ? 0 : log_max_lines_idx);
+  log_spill->setChecked(settings.value("prefs/log-spill", false).toBool());
+  sample_folders_list->addItems(settings.value("prefs/sample-folders").toStringList());
   show_line_numbers->setChecked(settings.value("prefs/show-line-numbers", true).toBool());
   enable_external_synths_cb->setChecked(settings.value("prefs/enable-external-synths", false).toBool());
   synth_trigger_timing_guarantees_cb->setChecked(settings.value("prefs/synth-trigger-timing-guarantees", false).toBool());
@@ -1682,6 +1695,21 @@ void MainWindow::startupError(QString msg) {
 void MainWindow::replaceBuffer(QString id, QString content, int line, int index, int first_line) {
   SonicPiScintilla* ws = filenameToWorkspace(id.toStdString());
   ws->replaceBuffer(content, line, index, first_line);
+  if (!savedWorkspaceHashes.contains(id)) {
+    // the first replace for a workspace is the reply to loadWorkspaces,
+    // so this is what is already on disk
+    markWorkspaceSaved(id, ws);
+    loaded_workspaces = true;
+  }
+}
+
+QByteArray MainWindow::workspaceHash(SonicPiScintilla* ws) {
+  return QCryptographicHash::hash(ws->text().toUtf8(), QCryptographicHash::Sha1);
+}
+
+void MainWindow::markWorkspaceSaved(QString id, SonicPiScintilla* ws) {
+  savedWorkspaceHashes[id] = workspaceHash(ws);
+  ws->setModified(false);
 }
 
 void MainWindow::replaceBufferIdx(int buf_idx, QString content, int line, int index, int first_line) {
@@ -1739,13 +1767,29 @@ void MainWindow::saveWorkspaces()
 {
   std::cout << "[GUI] - saving workspaces" << std::endl;
 
+  // only send the workspaces which changed since they were last loaded,
+  // run or saved, all in one message so the server makes one commit
+  Message msg("/save-buffers");
+  msg.pushStr(guiID.toStdString());
+  int count = 0;
   for(int i = 0; i < workspace_max; i++) {
-    std::string code = workspaces[i]->text().toStdString();
-    Message msg("/save-buffer");
-    msg.pushStr(guiID.toStdString());
-    std::string s = "workspace_" + number_name(i);
-    msg.pushStr(s);
-    msg.pushStr(code);
+    SonicPiScintilla* ws = workspaces[i];
+    QString id = QString::fromStdString("workspace_" + number_name(i));
+    // never overwrite a workspace we haven't loaded yet
+    if (!savedWorkspaceHashes.contains(id) || !ws->isModified()) continue;
+    if (workspaceHash(ws) == savedWorkspaceHashes[id]) {
+      // edited back to what was saved
+      ws->setModified(false);
+      continue;
+    }
+    msg.pushStr(id.toStdString());
+    msg.pushStr(ws->text().toStdString());
+    markWorkspaceSaved(id, ws);
+    count++;
+  }
+
+  std::cout << "[GUI] - " << count << " workspaces changed" << std::endl;
+  if (count > 0) {
     sendOSC(msg);
   }
 }
@@ -1840,11 +1884,11 @@ void MainWindow::runCode()
   resetErrorPane();
   statusBar()->showMessage(tr("Running Code..."), 1000);
   std::string code = ws->text().toStdString();
-  Message msg("/save-and-run-buffer");
-  msg.pushStr(guiID.toStdString());
-
-  std::string filename = ((SonicPiScintilla*)tabs->currentWidget())->fileName.toStdString();
-  msg.pushStr(filename);
+  std::string filename = ws->fileName.toStdString();
+  // running saves the buffer too
+  if (savedWorkspaceHashes.contains(ws->fileName)) {
+    markWorkspaceSaved(ws->fileName, ws);
+  }
 
   if(!print_output->isChecked()) {
     code = "use_debug false #__nosave__ set by Qt GUI user preferences.\n" + code ;
@@ -1874,11 +1918,100 @@ void MainWindow::runCode()
   }
 
 
+  sendRunCode(filename, code);
+
+  QTimer::singleShot(500, this, SLOT(unhighlightCode()));
+}
+
+static std::vector<std::string> splitLines(const std::string &code)
+{
+  // keep the newlines so the server can join the lines back up as is
+  std::vector<std::string> lines;
+  size_t start = 0;
+  while (start < code.size()) {
+    size_t end = code.find('\n', start);
+    end = (end == std::string::npos) ? code.size() : end + 1;
+    lines.push_back(code.substr(start, end - start));
+    start = end;
+  }
+  return lines;
+}
+
+void MainWindow::sendRunCode(const std::string &filename, const std::string &code)
+{
+  QString id = QString::fromStdString(filename);
+  std::string base = lastRunCode.value(id);
+  lastRunCode[id] = code;
+
+  if (code.size() >= RUN_DELTA_MIN_SIZE && !base.empty()) {
+    // only send the lines that changed since the last run of this
+    // buffer. The server checks it still has the same code to apply
+    // them to and asks for the whole buffer otherwise.
+    std::vector<std::string> old_lines = splitLines(base);
+    std::vector<std::string> new_lines = splitLines(code);
+    size_t prefix = 0;
+    while (prefix < old_lines.size() && prefix < new_lines.size() && old_lines[prefix] == new_lines[prefix]) {
+      prefix++;
+    }
+    size_t suffix = 0;
+    while (suffix < old_lines.size() - prefix && suffix < new_lines.size() - prefix &&
+           old_lines[old_lines.size() - 1 - suffix] == new_lines[new_lines.size() - 1 - suffix]) {
+      suffix++;
+    }
+    std::string replacement;
+    for (size_t i = prefix; i < new_lines.size() - suffix; i++) {
+      replacement += new_lines[i];
+    }
+
+    if (replacement.size() <= code.size() / 2) {
+      Message msg("/save-and-run-buffer-delta");
+      msg.pushStr(guiID.toStdString());
+      msg.pushStr(filename);
+      msg.pushInt32((int32_t)OscSender::checksum(base.data(), base.size()));
+      msg.pushInt32((int32_t)prefix);
+      msg.pushInt32((int32_t)(old_lines.size() - suffix));
+      msg.pushStr(replacement);
+      msg.pushStr(filename);
+      // echoed back in /buffer/delta-failed so we know which run failed
+      msg.pushInt32((int32_t)OscSender::checksum(code.data(), code.size()));
+      sendOSC(msg);
+      return;
+    }
+  }
+
+  Message msg("/save-and-run-buffer");
+  msg.pushStr(guiID.toStdString());
+  msg.pushStr(filename);
   msg.pushStr(code);
   msg.pushStr(filename);
   sendOSC(msg);
+}
 
-  QTimer::singleShot(500, this, SLOT(unhighlightCode()));
+void MainWindow::resendBuffer(QString id, int runChecksum)
+{
+  // the server couldn't apply a delta, so send the whole buffer. If
+  // the buffer has been run again since, that later run supersedes
+  // the failed one and will be answered on its own.
+  if (!lastRunCode.contains(id)) return;
+  const std::string &code = lastRunCode[id];
+  if ((int32_t)OscSender::checksum(code.data(), code.size()) != runChecksum) return;
+  Message msg("/save-and-run-buffer");
+  msg.pushStr(guiID.toStdString());
+  msg.pushStr(id.toStdString());
+  msg.pushStr(code);
+  msg.pushStr(id.toStdString());
+  sendOSC(msg);
+}
+
+void MainWindow::scsynthBooted()
+{
+  // scsynth creates a fresh shared memory segment each time it boots
+  scopeInterface->resetScope();
+}
+
+void MainWindow::transferAcked(int id, bool ok)
+{
+  oscSender->transferAcked(id, ok);
 }
 
 void MainWindow::unhighlightCode()
@@ -1914,7 +2047,7 @@ void MainWindow::beautifyCode()
   int first_line = ws->firstVisibleLine();
   Message msg("/buffer-beautify");
   msg.pushStr(guiID.toStdString());
-  std::string filename = ((SonicPiScintilla*)tabs->currentWidget())->fileName.toStdString();
+  std::string filename = ws->fileName.toStdString();
   msg.pushStr(filename);
   msg.pushStr(code);
   msg.pushInt32(line);
@@ -2059,9 +2192,9 @@ void MainWindow::scope()
 
   if (pro_icons_check->isChecked()) {
     if (show_scopes->isChecked()) {
-        scopeAct->setIcon(pro_scope_bordered_icon);
+        scopeAct->setIcon(toolbarIcon("pro/scope-bordered"));
       } else {
-      scopeAct->setIcon(pro_scope_icon);
+      scopeAct->setIcon(toolbarIcon("pro/scope"));
     }
   }
 
@@ -2080,9 +2213,9 @@ void MainWindow::about()
     infoWidg->hide();
     if (pro_icons_check->isChecked()) {
       if (dark_mode->isChecked()) {
-        infoAct->setIcon(pro_info_dark_icon);
+        infoAct->setIcon(toolbarIcon("pro/info-dark"));
       } else {
-        infoAct->setIcon(pro_info_icon);
+        infoAct->setIcon(toolbarIcon("pro/info"));
       }
     }
 
@@ -2091,9 +2224,9 @@ void MainWindow::about()
     infoWidg->show();
     if (pro_icons_check->isChecked()) {
       if (dark_mode->isChecked()) {
-        infoAct->setIcon(pro_info_dark_bordered_icon);
+        infoAct->setIcon(toolbarIcon("pro/info-dark-bordered"));
       } else {
-        infoAct->setIcon(pro_info_bordered_icon);
+        infoAct->setIcon(toolbarIcon("pro/info-bordered"));
       }
     }
   }
@@ -2107,9 +2240,9 @@ void MainWindow::help()
     docWidget->hide();
     if (pro_icons_check->isChecked()) {
       if (dark_mode->isChecked()) {
-        helpAct->setIcon(pro_help_dark_icon);
+        helpAct->setIcon(toolbarIcon("pro/help-dark"));
       } else {
-        helpAct->setIcon(pro_help_icon);
+        helpAct->setIcon(toolbarIcon("pro/help"));
       }
     }
   } else {
@@ -2120,9 +2253,9 @@ void MainWindow::help()
     }
     if (pro_icons_check->isChecked()) {
       if (dark_mode->isChecked()) {
-        helpAct->setIcon(pro_help_dark_bordered_icon);
+        helpAct->setIcon(toolbarIcon("pro/help-dark-bordered"));
       } else {
-        helpAct->setIcon(pro_help_bordered_icon);
+        helpAct->setIcon(toolbarIcon("pro/help-bordered"));
       }
     }
   }
@@ -2146,6 +2279,7 @@ void MainWindow::helpContext()
 
   if (helpKeywords.contains(selection)) {
     struct help_entry entry = helpKeywords[selection];
+    populateHelpTab(entry.pageIndex);
     QListWidget *list = helpLists[entry.pageIndex];
 
     // force current row to be changed
@@ -2230,87 +2364,101 @@ void MainWindow::updateLogAutoScroll() {
   }
  }
 
+void MainWindow::updateLogLimits() {
+  int max_lines = log_max_lines_combo->itemData(log_max_lines_combo->currentIndex()).toInt();
+  outputPane->setMaxLines(max_lines);
+  incomingPane->setMaxLines(max_lines);
+
+  if(log_spill->isChecked()) {
+    outputPane->setSpillPath(QDir::toNativeSeparators(log_path + "/output-pane.log"));
+    incomingPane->setSpillPath(QDir::toNativeSeparators(log_path + "/cues-pane.log"));
+  } else {
+    outputPane->setSpillPath("");
+    incomingPane->setSpillPath("");
+  }
+}
+
 void MainWindow::toggleIcons() {
   if (pro_icons_check->isChecked()) {
 
     toolBar->setIconSize(QSize(30, 30));
     if (dark_mode->isChecked()) {
-      runAct->setIcon(pro_run_icon);
-      stopAct->setIcon(pro_stop_icon);
-      saveAsAct->setIcon(pro_save_dark_icon);
-      loadFileAct->setIcon(pro_load_dark_icon);
-      recAct->setIcon(pro_rec_icon);
-      textIncAct->setIcon(pro_size_up_icon);
-      textDecAct->setIcon(pro_size_down_icon);
+      runAct->setIcon(toolbarIcon("pro/run"));
+      stopAct->setIcon(toolbarIcon("pro/stop"));
+      saveAsAct->setIcon(toolbarIcon("pro/save-dark"));
+      loadFileAct->setIcon(toolbarIcon("pro/load-dark"));
+      recAct->setIcon(toolbarIcon("pro/rec"));
+      textIncAct->setIcon(toolbarIcon("pro/size-up"));
+      textDecAct->setIcon(toolbarIcon("pro/size-down"));
 
       if (show_scopes->isChecked()) {
-          scopeAct->setIcon(pro_scope_bordered_icon);
+          scopeAct->setIcon(toolbarIcon("pro/scope-bordered"));
         } else {
-        scopeAct->setIcon(pro_scope_icon);
+        scopeAct->setIcon(toolbarIcon("pro/scope"));
       }
 
       if (infoWidg->isVisible()) {
-        infoAct->setIcon(pro_info_dark_bordered_icon);
+        infoAct->setIcon(toolbarIcon("pro/info-dark-bordered"));
       } else {
-        infoAct->setIcon(pro_info_dark_icon);
+        infoAct->setIcon(toolbarIcon("pro/info-dark"));
       }
 
       if (docWidget->isVisible()) {
-        helpAct->setIcon(pro_help_dark_bordered_icon);
+        helpAct->setIcon(toolbarIcon("pro/help-dark-bordered"));
       } else {
-        helpAct->setIcon(pro_help_dark_icon);
+        helpAct->setIcon(toolbarIcon("pro/help-dark"));
       }
 
       if (prefsWidget->isVisible()) {
-        prefsAct->setIcon(pro_prefs_dark_bordered_icon);
+        prefsAct->setIcon(toolbarIcon("pro/prefs-dark-bordered"));
       } else {
-        prefsAct->setIcon(pro_prefs_dark_icon);
+        prefsAct->setIcon(toolbarIcon("pro/prefs-dark"));
       }
     } else {
 
-      runAct->setIcon(pro_run_icon);
-      stopAct->setIcon(pro_stop_icon);
-      saveAsAct->setIcon(pro_save_icon);
-      loadFileAct->setIcon(pro_load_icon);
-      recAct->setIcon(pro_rec_icon);
+      runAct->setIcon(toolbarIcon("pro/run"));
+      stopAct->setIcon(toolbarIcon("pro/stop"));
+      saveAsAct->setIcon(toolbarIcon("pro/save"));
+      loadFileAct->setIcon(toolbarIcon("pro/load"));
+      recAct->setIcon(toolbarIcon("pro/rec"));
 
-      textIncAct->setIcon(pro_size_up_icon);
-      textDecAct->setIcon(pro_size_down_icon);
+      textIncAct->setIcon(toolbarIcon("pro/size-up"));
+      textDecAct->setIcon(toolbarIcon("pro/size-down"));
 
       if (show_scopes->isChecked()) {
-          scopeAct->setIcon(pro_scope_bordered_icon);
+          scopeAct->setIcon(toolbarIcon("pro/scope-bordered"));
         } else {
-        scopeAct->setIcon(pro_scope_icon);
+        scopeAct->setIcon(toolbarIcon("pro/scope"));
       }
 
 
       if (infoWidg->isVisible()) {
-        infoAct->setIcon(pro_info_bordered_icon);
+        infoAct->setIcon(toolbarIcon("pro/info-bordered"));
       } else {
-        infoAct->setIcon(pro_info_icon);
+        infoAct->setIcon(toolbarIcon("pro/info"));
       }
 
       if (docWidget->isVisible()) {
-        helpAct->setIcon(pro_help_bordered_icon);
+        helpAct->setIcon(toolbarIcon("pro/help-bordered"));
       } else {
-        helpAct->setIcon(pro_help_icon);
+        helpAct->setIcon(toolbarIcon("pro/help"));
       }
 
-      prefsAct->setIcon(pro_prefs_icon);
+      prefsAct->setIcon(toolbarIcon("pro/prefs"));
     }
   } else {
     toolBar->setIconSize(QSize(73, 30));
-    runAct->setIcon(QIcon(":/images/toolbar/default/run.png"));
-    stopAct->setIcon(QIcon(":/images/toolbar/default/stop.png"));
-    saveAsAct->setIcon(QIcon(":/images/toolbar/default/save.png"));
-    loadFileAct->setIcon(QIcon(":/images/toolbar/default/load.png"));
-    recAct->setIcon(QIcon(":/images/toolbar/default/rec.png"));
-    textIncAct->setIcon(QIcon(":/images/toolbar/default/size_up.png"));
-    textDecAct->setIcon(QIcon(":/images/toolbar/default/size_down.png"));
-    scopeAct->setIcon(QIcon(":/images/toolbar/default/scope.png"));
-    infoAct->setIcon(QIcon(":/images/toolbar/default/info.png"));
-    helpAct->setIcon(QIcon(":/images/toolbar/default/help.png"));
-    prefsAct->setIcon(QIcon(":/images/toolbar/default/prefs.png"));
+    runAct->setIcon(toolbarIcon("default/run"));
+    stopAct->setIcon(toolbarIcon("default/stop"));
+    saveAsAct->setIcon(toolbarIcon("default/save"));
+    loadFileAct->setIcon(toolbarIcon("default/load"));
+    recAct->setIcon(toolbarIcon("default/rec"));
+    textIncAct->setIcon(toolbarIcon("default/size_up"));
+    textDecAct->setIcon(toolbarIcon("default/size_down"));
+    scopeAct->setIcon(toolbarIcon("default/scope"));
+    infoAct->setIcon(toolbarIcon("default/info"));
+    helpAct->setIcon(toolbarIcon("default/help"));
+    prefsAct->setIcon(toolbarIcon("default/prefs"));
   }
 
 }
@@ -2330,9 +2478,9 @@ void MainWindow::updateDarkMode(){
   //Set css stylesheet for browser-like HTML widgets
   QString css = "";
   if(dark_mode->isChecked()) {
-    css = readFile(qt_browser_dark_css);
+    css = readCachedFile(qt_browser_dark_css);
   } else {
-    css = readFile(qt_browser_light_css);
+    css = readCachedFile(qt_browser_light_css);
   }
   docPane->document()->setDefaultStyleSheet(css);
   docPane->reload();
@@ -2419,7 +2567,7 @@ void MainWindow::updateDarkMode(){
   QString selectionBackgroundColor = currentTheme->color("SelectionBackground").name();
   QString errorBackgroundColor = currentTheme->color("ErrorBackground").name();
 
-  QString appStyling = readFile(qt_app_theme_path);
+  QString appStyling = readCachedFile(qt_app_theme_path);
 
   appStyling.replace("fixedWidthFont", "\"Hack\"");
 
@@ -2516,15 +2664,15 @@ void MainWindow::updatePrefsIcon()
   if(pro_icons_check->isChecked()) {
     if(prefsWidget->isVisible()) {
       if (dark_mode->isChecked()) {
-        prefsAct->setIcon(pro_prefs_dark_bordered_icon);
+        prefsAct->setIcon(toolbarIcon("pro/prefs-dark-bordered"));
       } else {
-        prefsAct->setIcon(pro_prefs_bordered_icon);
+        prefsAct->setIcon(toolbarIcon("pro/prefs-bordered"));
       }
     } else {
       if (dark_mode->isChecked()) {
-        prefsAct->setIcon(pro_prefs_dark_icon);
+        prefsAct->setIcon(toolbarIcon("pro/prefs-dark"));
       } else {
-        prefsAct->setIcon(pro_prefs_icon);
+        prefsAct->setIcon(toolbarIcon("pro/prefs"));
       }
     }
   }
@@ -2664,29 +2812,29 @@ void MainWindow::createShortcuts()
 void MainWindow::createToolBar()
 {
   // Run
-  runAct = new QAction(QIcon(":/images/toolbar/default/run.png"), tr("Run"), this);
+  runAct = new QAction(toolbarIcon("default/run"), tr("Run"), this);
   setupAction(runAct, 'R', tr("Run the code in the current buffer"),
 	      SLOT(runCode()));
   new QShortcut(QKeySequence(metaKeyModifier() + Qt::Key_Return), this, SLOT(runCode()));
 
   // Stop
-  stopAct = new QAction(QIcon(":/images/toolbar/default/stop.png"), tr("Stop"), this);
+  stopAct = new QAction(toolbarIcon("default/stop"), tr("Stop"), this);
   setupAction(stopAct, 'S', tr("Stop all running code"), SLOT(stopCode()));
 
   // Save
-  saveAsAct = new QAction(QIcon(":/images/toolbar/default/save.png"), tr("Save As..."), this);
+  saveAsAct = new QAction(toolbarIcon("default/save"), tr("Save As..."), this);
   QString saveFileDesc = tooltipStrShiftMeta('S', tr("Save current buffer as an external file"));
   setupAction(saveAsAct, 0, saveFileDesc, SLOT(saveAs()));
   saveAsAct->setToolTip(saveFileDesc);
 
   // Load
-  loadFileAct = new QAction(QIcon(":/images/toolbar/default/load.png"), tr("Load"), this);
+  loadFileAct = new QAction(toolbarIcon("default/load"), tr("Load"), this);
   QString loadFileDesc = tooltipStrShiftMeta('O', tr("Load an external file in the current buffer"));
   setupAction(loadFileAct, 0, loadFileDesc, SLOT(loadFile()));
   loadFileAct->setToolTip(loadFileDesc);
 
   // Record
-  recAct = new QAction(QIcon(":/images/toolbar/default/rec.png"), tr("Start Recording"), this);
+  recAct = new QAction(toolbarIcon("default/rec"), tr("Start Recording"), this);
   setupAction(recAct, 0, tr("Start recording to WAV audio file"), SLOT(toggleRecording()));
 
   // Align
@@ -2696,14 +2844,14 @@ void MainWindow::createToolBar()
 
   // Font Size Increase
   QString sizeUpDesc = tooltipStrMeta('+', tr("Increase Text Size"));
-  textIncAct = new QAction(QIcon(":/images/toolbar/default/size_up.png"),
+  textIncAct = new QAction(toolbarIcon("default/size_up"),
                                     tr("Size Up"), this);
   setupAction(textIncAct, 0, sizeUpDesc, SLOT(zoomCurrentWorkspaceIn()));
   textIncAct->setToolTip(sizeUpDesc);
 
   // Font Size Decrease
   QString sizeDownDesc = tooltipStrMeta('-', tr("Decrease Text Size"));
-  textDecAct = new QAction(QIcon(":/images/toolbar/default/size_down.png"),
+  textDecAct = new QAction(toolbarIcon("default/size_down"),
                                     tr("Size Down"), this);
   setupAction(textDecAct, 0, sizeDownDesc, SLOT(zoomCurrentWorkspaceOut()));
   textDecAct->setToolTip(sizeDownDesc);
@@ -2713,13 +2861,13 @@ void MainWindow::createToolBar()
   setupAction(scopeAct, 0, tr("Toggle the visibility of the audio oscilloscopes. "), SLOT(toggleScope()));
 
     // Info
-  infoAct = new QAction(QIcon(":/images/toolbar/default/scope.png"), tr("Info"), this);
+  infoAct = new QAction(toolbarIcon("default/scope"), tr("Info"), this);
   setupAction(infoAct, 0, tr("See information about Sonic Pi"),
 	      SLOT(about()));
 
 
   // Help
-  helpAct = new QAction(QIcon(":/images/toolbar/default/scope.png"), tr("Help"), this);
+  helpAct = new QAction(toolbarIcon("default/scope"), tr("Help"), this);
   setupAction(helpAct, 'I', tr("Toggle the visibility of the help pane"), SLOT(help()));
 
   // Preferences
@@ -2774,6 +2922,17 @@ QString MainWindow::readFile(QString name)
   return st.readAll();
 }
 
+// Stylesheets are reread on every switch between dark and light mode,
+// so keep hold of them after the first read
+QString MainWindow::readCachedFile(QString name)
+{
+  QHash<QString, QString>::const_iterator it = fileCache.constFind(name);
+  if (it != fileCache.constEnd()) return it.value();
+  QString content = readFile(name);
+  fileCache.insert(name, content);
+  return content;
+}
+
 void MainWindow::createInfoPane() {
   QTabWidget* infoTabs = new QTabWidget(this);
 
@@ -2826,19 +2985,19 @@ void MainWindow::toggleRecordingOnIcon() {
   show_rec_icon_a = !show_rec_icon_a;
   if (pro_icons_check->isChecked()) {
     if(show_rec_icon_a) {
-      recAct->setIcon(pro_rec_icon);
+      recAct->setIcon(toolbarIcon("pro/rec"));
     } else {
       if (dark_mode->isChecked()) {
-        recAct->setIcon(pro_rec_b_dark_icon);
+        recAct->setIcon(toolbarIcon("pro/recording-b-dark"));
       } else {
-        recAct->setIcon(pro_rec_b_icon);
+        recAct->setIcon(toolbarIcon("pro/recording-b"));
       }
     }
   } else {
     if(show_rec_icon_a) {
-      recAct->setIcon(QIcon(":/images/toolbar/default/recording_a.png"));
+      recAct->setIcon(toolbarIcon("default/recording_a"));
     } else {
-      recAct->setIcon(QIcon(":/images/toolbar/default/recording_b.png"));
+      recAct->setIcon(toolbarIcon("default/recording_b"));
     }
   }
 }
@@ -2857,9 +3016,9 @@ void MainWindow::toggleRecording() {
     recAct->setStatusTip(tr("Start Recording"));
     recAct->setToolTip(tr("Start Recording"));
     if (pro_icons_check->isChecked()) {
-        recAct->setIcon(QIcon(":/images/toolbar/pro/rec.png"));
+        recAct->setIcon(toolbarIcon("pro/rec"));
     } else {
-      recAct->setIcon(QIcon(":/images/toolbar/default/rec.png"));
+      recAct->setIcon(toolbarIcon("default/rec"));
     }
     Message msg("/stop-recording");
     msg.pushStr(guiID.toStdString());
@@ -2938,6 +3097,13 @@ void MainWindow::writeSettings()
   settings.setValue("prefs/clear-output-on-run", clear_output_on_run->isChecked());
   settings.setValue("prefs/log-cues", log_cues->isChecked());
   settings.setValue("prefs/log-auto-scroll", log_auto_scroll->isChecked());
+  settings.setValue("prefs/log-max-lines", log_max_lines_combo->itemData(log_max_lines_combo->currentIndex()).toInt());
+  settings.setValue("prefs/log-spill", log_spill->isChecked());
+  QStringList sample_folders;
+  for (int i = 0; i < sample_folders_list->count(); i++) {
+    sample_folders << sample_folders_list->item(i)->text();
+  }
+  settings.setValue("prefs/sample-folders", sample_folders);
   settings.setValue("prefs/show-line-numbers", show_line_numbers->isChecked());
   settings.setValue("prefs/enable-external-synths", enable_external_synths_cb->isChecked());
   settings.setValue("prefs/synth-trigger-timing-guarantees", synth_trigger_timing_guarantees_cb->isChecked());
@@ -3083,35 +3249,62 @@ void MainWindow::updateDocPane2(QListWidgetItem *cur, QListWidgetItem *prev) {
 }
 
 void MainWindow::addHelpPage(QListWidget *nameList,
-                             struct help_page *helpPages, int len) {
+                             const struct help_page *helpPages, int len) {
   int i;
   struct help_entry entry;
   entry.pageIndex = docsCentral->count()-1;
 
-  for(i = 0; i < len; i++) {
-    QListWidgetItem *item = new QListWidgetItem(helpPages[i].title);
-    item->setData(32, QVariant(helpPages[i].url));
-    item->setSizeHint(QSize(item->sizeHint().width(), 25));
-    nameList->addItem(item);
-    entry.entryIndex = nameList->count()-1;
+  // the list itself is filled in by populateHelpTab when first shown
+  help_tab tab = { helpPages, len, false };
+  helpTabs.append(tab);
 
+  QStringList keywords;
+  for(i = 0; i < len; i++) {
     if (helpPages[i].keyword != NULL) {
-      helpKeywords.insert(helpPages[i].keyword, entry);
+      entry.entryIndex = i;
+      QString keyword = QString::fromUtf8(helpPages[i].keyword);
+      helpKeywords.insert(keyword, entry);
       // magic numbers ahoy
       // to be revamped along with the help system
       switch (entry.pageIndex) {
       case 2:
-        autocomplete->addSymbol(SonicPiAPIs::Synth, helpPages[i].keyword);
-        break;
       case 3:
-        autocomplete->addSymbol(SonicPiAPIs::FX, helpPages[i].keyword);
+        keywords << ":" + keyword;
         break;
       case 5:
-        autocomplete->addKeyword(SonicPiAPIs::Func, helpPages[i].keyword);
+        keywords << keyword;
         break;
       }
     }
   }
+
+  switch (entry.pageIndex) {
+  case 2:
+    autocomplete->addKeywords(SonicPiAPIs::Synth, keywords);
+    break;
+  case 3:
+    autocomplete->addKeywords(SonicPiAPIs::FX, keywords);
+    break;
+  case 5:
+    autocomplete->addKeywords(SonicPiAPIs::Func, keywords);
+    break;
+  }
+}
+
+void MainWindow::populateHelpTab(int index) {
+  if (index < 0 || index >= helpTabs.size() || helpTabs[index].populated) return;
+  help_tab &tab = helpTabs[index];
+  tab.populated = true;
+
+  QListWidget *nameList = helpLists[index];
+  nameList->setUpdatesEnabled(false);
+  for(int i = 0; i < tab.len; i++) {
+    QListWidgetItem *item = new QListWidgetItem(QString::fromUtf8(tab.pages[i].title));
+    item->setData(32, QVariant(QString::fromUtf8(tab.pages[i].url)));
+    item->setSizeHint(QSize(item->sizeHint().width(), 25));
+    nameList->addItem(item);
+  }
+  nameList->setUpdatesEnabled(true);
 }
 
 QListWidget *MainWindow::createHelpTab(QString name) {
@@ -3140,8 +3333,38 @@ QListWidget *MainWindow::createHelpTab(QString name) {
   return nameList;
 }
 
+void MainWindow::searchHelp(const QString &query) {
+  helpSearchResults->clear();
+  if (query.trimmed().isEmpty()) {
+    helpSearchResults->hide();
+    docsCentral->show();
+    return;
+  }
+
+  // the index covers the tutorial in every language, so only offer the
+  // pages of the tabs we actually loaded
+  if (helpUrls.isEmpty()) {
+    foreach (const help_tab &tab, helpTabs) {
+      for (int i = 0; i < tab.len; i++) {
+        helpUrls.insert(QString::fromUtf8(tab.pages[i].url));
+      }
+    }
+  }
+
+  QList<HelpSearchIndex::Result> results = helpSearch->search(query, 100, helpUrls);
+  foreach (const HelpSearchIndex::Result &r, results) {
+    QListWidgetItem *item = new QListWidgetItem(r.title);
+    item->setData(32, QVariant(r.url));
+    item->setSizeHint(QSize(item->sizeHint().width(), 25));
+    helpSearchResults->addItem(item);
+  }
+  docsCentral->hide();
+  helpSearchResults->show();
+}
+
 void MainWindow::helpScrollUp() {
   int section = docsCentral->currentIndex();
+  populateHelpTab(section);
   int entry = helpLists[section]->currentRow();
 
   if (entry > 0)
@@ -3151,6 +3374,7 @@ void MainWindow::helpScrollUp() {
 
 void MainWindow::helpScrollDown() {
   int section = docsCentral->currentIndex();
+  populateHelpTab(section);
   int entry = helpLists[section]->currentRow();
 
   if (entry < helpLists[section]->count()-1)
@@ -3168,18 +3392,21 @@ void MainWindow::docScrollDown() {
 
 void MainWindow::helpVisibilityChanged() {
   statusBar()->showMessage(tr("help visibility changed..."), 2000);
+  if (docWidget->isVisible()) {
+    populateHelpTab(docsCentral->currentIndex());
+  }
   if(pro_icons_check->isChecked()) {
     if (docWidget->isVisible()) {
       if (dark_mode->isChecked()) {
-        helpAct->setIcon(QIcon(":/images/toolbar/pro/help-dark-bordered.png"));
+        helpAct->setIcon(toolbarIcon("pro/help-dark-bordered"));
       } else {
-        helpAct->setIcon(QIcon(":/images/toolbar/pro/help-bordered.png"));
+        helpAct->setIcon(toolbarIcon("pro/help-bordered"));
       }
     } else {
       if (dark_mode->isChecked()) {
-        helpAct->setIcon(QIcon(":/images/toolbar/pro/help-dark.png"));
+        helpAct->setIcon(toolbarIcon("pro/help-dark"));
       } else {
-        helpAct->setIcon(QIcon(":/images/toolbar/pro/help.png"));
+        helpAct->setIcon(toolbarIcon("pro/help"));
       }
     }
   }
@@ -3222,6 +3449,16 @@ void MainWindow::addUniversalCopyShortcuts(QTextEdit *te){
   new QShortcut(metaKey('a'), te, SLOT(selectAll()));
 }
 
+// Toolbar icons are only decoded when an icon set first shows them,
+// as only one of the default and pro sets, in light or dark, is used.
+const QIcon &MainWindow::toolbarIcon(const QString &name){
+  QHash<QString, QIcon>::iterator it = toolbarIcons.find(name);
+  if (it == toolbarIcons.end()) {
+    it = toolbarIcons.insert(name, QIcon(":/images/toolbar/" + name + ".png"));
+  }
+  return it.value();
+}
+
 QString MainWindow::asciiArtLogo(){
   return readFile(":/images/logo.txt");
 }
@@ -3274,16 +3511,39 @@ void MainWindow::updateVersionNumber(QString v, int v_num,QString latest_v, int
   }
 }
 
+void MainWindow::addSampleFolder()
+{
+  QString dir = QFileDialog::getExistingDirectory(this, tr("Add Sample Folder"), QDir::homePath());
+  if (dir.isEmpty() || !sample_folders_list->findItems(dir, Qt::MatchExactly).isEmpty()) return;
+  sample_folders_list->addItem(dir);
+  sampleIndexer->addFolder(dir, false);
+}
+
+void MainWindow::removeSampleFolder()
+{
+  QListWidgetItem *item = sample_folders_list->currentItem();
+  if (!item) return;
+  sampleIndexer->removeFolder(item->text());
+  delete item;
+}
+
+void MainWindow::addSampleNames(QStringList names)
+{
+  autocomplete->addKeywords(SonicPiAPIs::Sample, names);
+}
+
+void MainWindow::removeSampleNames(QStringList names)
+{
+  autocomplete->removeKeywords(SonicPiAPIs::Sample, names);
+}
+
 void MainWindow::addCuePath(QString path, QString val)
 {
   if (!path.startsWith(":"))  {
       path =  "\"" + path + "\"";
   }
 
-  if (!cuePaths.contains(path)) {
-      autocomplete->addCuePath(path);
-      cuePaths << path;
-  }
+  autocomplete->addCuePath(path);
 }
 
 
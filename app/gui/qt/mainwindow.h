@@ -30,8 +30,8 @@
 #include <QFuture>
 #include <QShortcut>
 #include <QSettings>
-#include <QSet>
 #include <QHash>
+#include <QSet>
 #include <QTcpSocket>
 #include "oscpkt.hh"
 #include "udp.hh"
@@ -55,14 +55,25 @@ class SonicPiLexer;
 class QString;
 class QSlider;
 class SonicPiAPIs;
+class SampleIndexer;
+class HelpSearchIndex;
+class QLineEdit;
 class SonicPiLog;
 class SonicPiScintilla;
 class SonicPiOSCServer;
 
+// Generated into ruby_help.h as static tables, so the help index costs
+// nothing until a tab's list is first shown. Strings are UTF-8.
 struct help_page {
-  QString title;
-  QString keyword;
-  QString url;
+  const char *title;
+  const char *keyword;
+  const char *url;
+};
+
+struct help_tab {
+  const struct help_page *pages;
+  int len;
+  bool populated;
 };
 
 struct help_entry {
@@ -96,10 +107,15 @@ public slots:
 
 private slots:
     void addCuePath(QString path, QString val);
+    void addSampleFolder();
+    void removeSampleFolder();
+    void addSampleNames(QStringList names);
+    void removeSampleNames(QStringList names);
     void zoomInLogs();
     void zoomOutLogs();
     QString sonicPiHomePath();
     void updateLogAutoScroll();
+    void updateLogLimits();
     bool eventFilter(QObject *obj, QEvent *evt);
     void changeTab(int id);
     QString asciiArtLogo();
@@ -107,6 +123,9 @@ private slots:
     void unhighlightCode();
     void runCode();
     void runBufferIdx(int idx);
+    void resendBuffer(QString id, int runChecksum);
+    void scsynthBooted();
+    void transferAcked(int id, bool ok);
     void update_mixer_invert_stereo();
     void update_mixer_force_mono();
     void update_check_updates();
@@ -170,6 +189,8 @@ private slots:
     void docScrollUp();
     void docScrollDown();
     void helpVisibilityChanged();
+    void populateHelpTab(int index);
+    void searchHelp(const QString &query);
     void updateFullScreenMode();
     void toggleFullScreenMode();
     void updateFocusMode();
@@ -222,14 +243,17 @@ private:
     bool saveFile(const QString &fileName, SonicPiScintilla* text);
     void loadWorkspaces();
     void saveWorkspaces();
+    QByteArray workspaceHash(SonicPiScintilla* ws);
+    void markWorkspaceSaved(QString id, SonicPiScintilla* ws);
     std::string number_name(int);
     std::string workspaceFilename(SonicPiScintilla* text);
     SonicPiScintilla* filenameToWorkspace(std::string filename);
     void sendOSC(oscpkt::Message m);
+    void sendRunCode(const std::string &filename, const std::string &code);
     void initPrefsWindow();
     void initDocsWindow();
     void refreshDocContent();
-    void addHelpPage(QListWidget *nameList, struct help_page *helpPages,
+    void addHelpPage(QListWidget *nameList, const struct help_page *helpPages,
                      int len);
     QListWidget *createHelpTab(QString name);
     QKeySequence metaKey(char key);
@@ -243,6 +267,8 @@ private:
     QString tooltipStrShiftMeta(char key, QString str);
     QString tooltipStrMeta(char key, QString str);
     QString readFile(QString name);
+    QString readCachedFile(QString name);
+    const QIcon &toolbarIcon(const QString &name);
     QString rootPath();
 
     void addUniversalCopyShortcuts(QTextEdit *te);
@@ -266,6 +292,9 @@ private:
     bool i18n;
     static const int workspace_max = 10;
     SonicPiScintilla *workspaces[workspace_max];
+    // content hash of each workspace as last loaded from or sent to the
+    // server, keyed by workspace id
+    QHash<QString, QByteArray> savedWorkspaceHashes;
     QWidget *prefsCentral;
     QTabWidget *docsCentral;
     SonicPiLog *outputPane;
@@ -314,6 +343,9 @@ private:
     QCheckBox *clear_output_on_run;
     QCheckBox *log_cues;
     QCheckBox *log_auto_scroll;
+    QComboBox *log_max_lines_combo;
+    QCheckBox *log_spill;
+    QListWidget *sample_folders_list;
     QCheckBox *enable_external_synths_cb;
     QCheckBox *synth_trigger_timing_guarantees_cb;
     QCheckBox *show_line_numbers;
@@ -352,11 +384,17 @@ private:
     QVBoxLayout *mainWidgetLayout;
 
     QList<QListWidget *> helpLists;
+    QList<help_tab> helpTabs;
+    HelpSearchIndex *helpSearch;
+    QLineEdit *helpSearchBox;
+    QListWidget *helpSearchResults;
+    QSet<QString> helpUrls;
     QHash<QString, help_entry> helpKeywords;
     std::streambuf *coutbuf;
     std::ofstream stdlog;
 
     SonicPiAPIs *autocomplete;
+    SampleIndexer *sampleIndexer;
     QString sample_path, log_path, sp_user_path, sp_user_tmp_path, ruby_server_path, ruby_path, server_error_log_path, server_output_log_path, gui_log_path, scsynth_log_path, init_script_path, exit_script_path, tmp_file_store, process_log_path, port_discovery_path, qt_app_theme_path, qt_browser_dark_css, qt_browser_light_css;
     QString defaultTextBrowserStyle;
 
@@ -374,9 +412,11 @@ private:
     bool updated_dark_mode_for_help, updated_dark_mode_for_prefs;
 
     OscSender *oscSender;
-    QSet<QString> cuePaths;
+    // code sent by the last run of each buffer, for sending deltas
+    QHash<QString, std::string> lastRunCode;
 
-    QIcon pro_run_icon, pro_stop_icon, pro_save_icon, pro_load_icon, pro_rec_icon, pro_size_up_icon, pro_size_down_icon, pro_scope_bordered_icon, pro_scope_icon, pro_info_bordered_icon, pro_info_icon, pro_help_bordered_icon, pro_help_icon, pro_prefs_icon, pro_prefs_bordered_icon, pro_info_dark_bordered_icon, pro_info_dark_icon, pro_help_dark_bordered_icon, pro_help_dark_icon, pro_prefs_dark_bordered_icon, pro_prefs_dark_icon, pro_rec_b_icon, pro_rec_b_dark_icon, pro_load_dark_icon, pro_save_dark_icon;
+    QHash<QString, QIcon> toolbarIcons;
+    QHash<QString, QString> fileCache;
 };
 
 #endif
@@ -14,6 +14,9 @@
 #ifndef OSCHANDLER_H
 #define OSCHANDLER_H
 
+#include <atomic>
+#include <ostream>
+
 #include "oscpkt.hh"
 #include "sonicpitheme.h"
 #include "mainwindow.h"
@@ -23,11 +26,47 @@ class OscHandler
 
 public:
   OscHandler(MainWindow *parent = 0, SonicPiLog *out = 0, QTextEdit *error = 0, SonicPiLog *incoming = 0, SonicPiTheme *theme = 0);
-    void oscMessage(std::vector<char> buffer);
+    // data must stay valid until the call returns, messages are parsed in place
+    void oscMessage(const char *data, size_t size);
     bool signal_server_stop;
     bool server_started;
+    bool server_booted;
+    // per address message counts, written to the log when the server stops
+    void printMessageCounts(std::ostream &os) const;
 
 private:
+    struct Route {
+      const char *address;
+      void (OscHandler::*handler)(oscpkt::Message *msg);
+    };
+    static const int NumRoutes = 20;
+    static const Route routes[];
+    static bool routeLess(const Route &a, const Route &b);
+
+    void handleLogMultiMessage(oscpkt::Message *msg);
+    void handleIncomingOsc(oscpkt::Message *msg);
+    void handleLogInfo(oscpkt::Message *msg);
+    void handleError(oscpkt::Message *msg);
+    void handleSyntaxError(oscpkt::Message *msg);
+    void handleBufferReplace(oscpkt::Message *msg);
+    void handleBufferReplaceIdx(oscpkt::Message *msg);
+    void handleBufferReplaceLines(oscpkt::Message *msg);
+    void handleBufferRunIdx(oscpkt::Message *msg);
+    void handleBufferDeltaFailed(oscpkt::Message *msg);
+    void handleChunkAck(oscpkt::Message *msg);
+    void handleUpdateInfoText(oscpkt::Message *msg);
+    void handleExited(oscpkt::Message *msg);
+    void handleExitedWithBootError(oscpkt::Message *msg);
+    void handleAck(oscpkt::Message *msg);
+    void handleBootPhase(oscpkt::Message *msg);
+    void handleMidiOutPorts(oscpkt::Message *msg);
+    void handleMidiInPorts(oscpkt::Message *msg);
+    void handleVersion(oscpkt::Message *msg);
+    void handleRunsAllCompleted(oscpkt::Message *msg);
+
+    std::atomic<unsigned long> route_counts[NumRoutes];
+    std::atomic<unsigned long> unhandled_count;
+
     SonicPiTheme *theme;
     MainWindow *window;
     SonicPiLog  *out;
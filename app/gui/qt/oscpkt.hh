@@ -222,6 +222,11 @@ class Message {
   std::string type_tags;
   std::vector<std::pair<size_t, size_t> > arguments; // array of pairs (pos,size), pos being an index into the 'storage' array.
   Storage storage; // the arguments data is stored here
+  /* Modified from original: when non-null the message was parsed in
+     place and its arguments live in these bytes (owned by the packet)
+     rather than in 'storage' */
+  const char *view_data;
+  size_t view_size;
   ErrorCode err;
 public:  
   /** ArgReader is used for popping arguments from a Message, holds a
@@ -293,11 +298,11 @@ public:
   private:
     const char *argBeg(size_t idx) {
       if (err || idx >= msg->arguments.size()) return 0; 
-      else return msg->storage.begin() + msg->arguments[idx].first;
+      else return msg->rawBegin() + msg->arguments[idx].first;
     }
     const char *argEnd(size_t idx) {
       if (err || idx >= msg->arguments.size()) return 0; 
-      else return msg->storage.begin() + msg->arguments[idx].first + msg->arguments[idx].second;
+      else return msg->rawBegin() + msg->arguments[idx].first + msg->arguments[idx].second;
     }
     int currentTypeTag() {
       if (!err && arg_idx < msg->type_tags.size()) return msg->type_tags[arg_idx];
@@ -320,7 +325,7 @@ public:
   };
 
   Message() { clear(); }
-  Message(const std::string &s, TimeTag tt = TimeTag::immediate()) : time_tag(tt), address(s), err(OK_NO_ERROR) {}
+  Message(const std::string &s, TimeTag tt = TimeTag::immediate()) : time_tag(tt), address(s), view_data(0), view_size(0), err(OK_NO_ERROR) {}
   Message(const void *ptr, size_t sz, TimeTag tt = TimeTag::immediate()) { buildFromRawData(ptr, sz); time_tag = tt; }
 
   bool isOk() const { return err == OK_NO_ERROR; }
@@ -365,31 +370,22 @@ public:
   void buildFromRawData(const void *ptr, size_t sz) {
     clear();
     storage.assign((const char*)ptr, (const char*)ptr + sz);
-    const char *address_beg = storage.begin();
-    const char *address_end = (const char*)memchr(address_beg, 0, storage.end()-address_beg);
-    if (!address_end || !isZeroPaddingCorrect(address_end+1) || address_beg[0] != '/') { 
-      OSCPKT_SET_ERR(MALFORMED_ADDRESS_PATTERN); return; 
-    } else address.assign(address_beg, address_end);
-
-    const char *type_tags_beg = ceil4(address_end+1);
-    const char *type_tags_end = (const char*)memchr(type_tags_beg, 0, storage.end()-type_tags_beg);
-    if (!type_tags_end || !isZeroPaddingCorrect(type_tags_end+1) || type_tags_beg[0] != ',') { 
-      OSCPKT_SET_ERR(MALFORMED_TYPE_TAGS); return; 
-    } else type_tags.assign(type_tags_beg+1, type_tags_end); // we do not copy the initial ','
+    parseRawData();
+  }
 
-    const char *arg = ceil4(type_tags_end+1); assert(arg <= storage.end()); 
-    size_t iarg = 0;
-    while (isOk() && iarg < type_tags.size()) {
-      assert(arg <= storage.end()); 
-      size_t len = getArgSize(type_tags[iarg], arg);
-      if (isOk()) arguments.push_back(std::make_pair(arg - storage.begin(), len));
-      arg += ceil4(len); ++iarg;
-    }
-    if (iarg < type_tags.size() || arg != storage.end()) {
-      OSCPKT_SET_ERR(MALFORMED_ARGUMENTS);
-    }
+  /** Modified from original: parse the osc message in place. No copy of
+      the data is made, so it must outlive the message (and any copy of
+      it). Reusing a Message this way also reuses its string buffers. */
+  void referenceRawData(const void *ptr, size_t sz, TimeTag tt = TimeTag::immediate()) {
+    clear();
+    view_data = (const char*)ptr; view_size = sz; time_tag = tt;
+    parseRawData();
   }
 
+  /** start and end of the raw bytes the arguments are read from */
+  const char *rawBegin() const { return view_data ? view_data : storage.begin(); }
+  const char *rawEnd() const { return view_data ? view_data + view_size : storage.end(); }
+
   /* below are all the functions that serve when *writing* a message */
   Message &pushBool(bool b) { 
     type_tags += (b ? TYPE_TAG_TRUE : TYPE_TAG_FALSE); 
@@ -420,6 +416,7 @@ public:
   /** reset the message to a clean state */
   void clear() { 
     address.clear(); type_tags.clear(); storage.clear(); arguments.clear(); 
+    view_data = 0; view_size = 0;
     err = OK_NO_ERROR; time_tag = TimeTag::immediate();
   }
 
@@ -437,11 +434,41 @@ public:
 
 private:
 
+  /* split the raw bytes (either our own storage or a referenced packet)
+     into address, type tags and argument positions */
+  void parseRawData() {
+    const char *beg = rawBegin(), *end = rawEnd();
+    const char *address_beg = beg;
+    const char *address_end = (const char*)memchr(address_beg, 0, end-address_beg);
+    if (!address_end || !isZeroPaddingCorrect(address_end+1) || address_beg[0] != '/') { 
+      OSCPKT_SET_ERR(MALFORMED_ADDRESS_PATTERN); return; 
+    } else address.assign(address_beg, address_end);
+
+    const char *type_tags_beg = ceil4(address_end+1);
+    const char *type_tags_end = (const char*)memchr(type_tags_beg, 0, end-type_tags_beg);
+    if (!type_tags_end || !isZeroPaddingCorrect(type_tags_end+1) || type_tags_beg[0] != ',') { 
+      OSCPKT_SET_ERR(MALFORMED_TYPE_TAGS); return; 
+    } else type_tags.assign(type_tags_beg+1, type_tags_end); // we do not copy the initial ','
+
+    const char *arg = ceil4(type_tags_end+1); assert(arg <= end); 
+    size_t iarg = 0;
+    while (isOk() && iarg < type_tags.size()) {
+      assert(arg <= end); 
+      size_t len = getArgSize(type_tags[iarg], arg);
+      if (isOk()) arguments.push_back(std::make_pair(arg - beg, len));
+      arg += ceil4(len); ++iarg;
+    }
+    if (iarg < type_tags.size() || arg != end) {
+      OSCPKT_SET_ERR(MALFORMED_ARGUMENTS);
+    }
+  }
+
   /* get the number of bytes occupied by the argument */
   size_t getArgSize(int type, const char *p) {
     if (err) return 0;
     size_t sz = 0;
-    assert(p >= storage.begin() && p <= storage.end());
+    const char *end = rawEnd();
+    assert(p >= rawBegin() && p <= end);
     switch (type) {
       case TYPE_TAG_TRUE:
       case TYPE_TAG_FALSE: sz = 0; break;
@@ -450,19 +477,19 @@ private:
       case TYPE_TAG_INT64: 
       case TYPE_TAG_DOUBLE: sz = 8; break;
       case TYPE_TAG_STRING: {
-        const char *q = (const char*)memchr(p, 0, storage.end()-p);
+        const char *q = (const char*)memchr(p, 0, end-p);
         if (!q) OSCPKT_SET_ERR(MALFORMED_ARGUMENTS);
         else sz = (q-p)+1;
       } break;
       case TYPE_TAG_BLOB: {
-        if (p == storage.end()) { OSCPKT_SET_ERR(MALFORMED_ARGUMENTS); return 0; }
+        if (p == end) { OSCPKT_SET_ERR(MALFORMED_ARGUMENTS); return 0; }
         sz = 4+bytes2pod<uint32_t>(p);
       } break;
       default: {
         OSCPKT_SET_ERR(UNHANDLED_TYPE_TAGS); return 0;
       } break;
     }
-    if (p+sz > storage.end() || /* string or blob too large.. */
+    if (p+sz > end || /* string or blob too large.. */
         p+sz < p /* or even blob so large that it did overflow */) { 
       OSCPKT_SET_ERR(MALFORMED_ARGUMENTS); return 0; 
     }
@@ -503,32 +530,38 @@ private:
 
 /**
    parse an OSC packet and extracts the embedded OSC messages. 
+
+   Modified from original: the messages reference the packet bytes
+   instead of copying them, so the packet must stay alive while its
+   messages are in use. The Message objects are kept between calls to
+   init() so a long lived reader does not allocate per packet.
 */
 class PacketReader {
 public:
-  PacketReader() { err = OK_NO_ERROR; }
+  PacketReader() { err = OK_NO_ERROR; nb_messages = 0; it_messages = 0; }
   /** pointer and size of the osc packet to be parsed. */
   PacketReader(const void *ptr, size_t sz) { init(ptr, sz); }
 
   void init(const void *ptr, size_t sz) {
-    err = OK_NO_ERROR; messages.clear();
+    err = OK_NO_ERROR; nb_messages = 0;
     if ((sz%4) == 0) { 
       parse((const char*)ptr, (const char *)ptr+sz, TimeTag::immediate());
     } else OSCPKT_SET_ERR(INVALID_PACKET_SIZE);
-    it_messages = messages.begin();
+    it_messages = 0;
   }
   
   /** extract the next osc message from the packet. return 0 when all messages have been read, or in case of error. */
   Message *popMessage() {
-    if (!err && !messages.empty() && it_messages != messages.end()) return &*it_messages++;
+    if (!err && it_messages < nb_messages) return &messages[it_messages++];
     else return 0;
   }
   bool isOk() const { return err == OK_NO_ERROR; }
   ErrorCode getErr() const { return err; }
 
 private:
-  std::list<Message> messages;
-  std::list<Message>::iterator it_messages;
+  std::vector<Message> messages;
+  size_t nb_messages;
+  size_t it_messages;
   ErrorCode err;
   
   void parse(const char *beg, const char *end, TimeTag time_tag) {
@@ -554,8 +587,10 @@ private:
         OSCPKT_SET_ERR(INVALID_BUNDLE);
       }
     } else {
-      messages.push_back(Message(beg, end-beg, time_tag));
-      if (!messages.back().isOk()) OSCPKT_SET_ERR(messages.back().getErr());
+      if (nb_messages == messages.size()) messages.push_back(Message());
+      Message &msg = messages[nb_messages++];
+      msg.referenceRawData(beg, end-beg, time_tag);
+      if (!msg.isOk()) OSCPKT_SET_ERR(msg.getErr());
     }
   }
 };
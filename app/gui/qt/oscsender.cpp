@@ -12,6 +12,8 @@
 //++
 
 
+#include <algorithm>
+
 // OSC stuff
 #include "oscpkt.hh"
 #include "udp.hh"
@@ -19,22 +21,221 @@
 #include "oscsender.h"
 using namespace oscpkt;
 
+// The server reads each datagram into a 16k buffer, so bundles are kept
+// below that. Messages which are bigger on their own are sent alone.
+static const size_t OSC_SENDER_MAX_BUNDLE = 16384;
+
+// "#bundle" plus the time tag, and the size prefix of each element
+static const size_t OSC_BUNDLE_HEADER = 16;
+static const size_t OSC_BUNDLE_ELEMENT_HEADER = 4;
+
+// payload of each /chunk fragment, and how long to wait for the server
+// to acknowledge a transfer before sending it again
+static const size_t OSC_CHUNK_SIZE = 8192;
+// the server refuses transfers of more fragments than this
+static const size_t OSC_MAX_CHUNKS = 256;
+static const int OSC_TRANSFER_RETRY_MS = 1000;
+static const int OSC_TRANSFER_MAX_ATTEMPTS = 5;
+
 OscSender::OscSender(int port)
 {
   this->port = port;
+  running = true;
+  nextTransferId = 0;
+  worker = std::thread(&OscSender::run, this);
+}
+
+OscSender::~OscSender()
+{
+  {
+    std::lock_guard<std::mutex> lock(queueMutex);
+    running = false;
+  }
+  wake.notify_one();
+  worker.join();
 }
 
 void OscSender::sendOSC(Message m) {
-  UdpSocket sock;
-  sock.connectTo("127.0.0.1", port);
-  if (!sock.isOk()) {
-    std::cerr << "[OSC Sender] - Error connecting to port " << port << ": " << sock.errorMessage() << "\n";
-  } else {
-    PacketWriter pw;
-    pw.addMessage(m);
-    sock.sendPacket(pw.packetData(), pw.packetSize());
+  {
+    std::lock_guard<std::mutex> lock(queueMutex);
+    queue.push_back(std::move(m));
+  }
+  wake.notify_one();
+}
+
+void OscSender::transferAcked(int id, bool ok) {
+  {
+    std::lock_guard<std::mutex> lock(queueMutex);
+    acks.push_back(std::make_pair(id, ok));
+  }
+  wake.notify_one();
+}
+
+void OscSender::run() {
+  std::deque<Message> batch;
+  std::deque<std::pair<int, bool> > ack_batch;
+  for (;;) {
+    {
+      std::unique_lock<std::mutex> lock(queueMutex);
+      auto ready = [this] { return !running || !queue.empty() || !acks.empty(); };
+      if (transfers.empty()) {
+        wake.wait(lock, ready);
+      } else {
+        wake.wait_for(lock, std::chrono::milliseconds(OSC_TRANSFER_RETRY_MS), ready);
+      }
+      if (!running && queue.empty()) {
+        // everything queued has gone out, unacknowledged transfers are
+        // not worth holding up exit for
+        return;
+      }
+      batch.swap(queue);
+      ack_batch.swap(acks);
+    }
+    handleAcks(ack_batch);
+    ack_batch.clear();
+    sendBatch(batch);
+    batch.clear();
+    retryTransfers();
+  }
+}
+
+void OscSender::sendBatch(std::deque<Message> &batch) {
+  size_t start = 0;
+  while (start < batch.size()) {
+    // take as many of the queued messages as fit in one datagram, but
+    // always at least one
+    size_t end = start;
+    size_t bundle_size = OSC_BUNDLE_HEADER;
+    while (end < batch.size()) {
+      size_t size = single.init().addMessage(batch[end]).packetSize() + OSC_BUNDLE_ELEMENT_HEADER;
+      if (end > start && bundle_size + size > OSC_SENDER_MAX_BUNDLE) break;
+      bundle_size += size;
+      end++;
+    }
+
+    if (end - start == 1) {
+      single.init().addMessage(batch[start]);
+      if (single.packetSize() > OSC_SENDER_MAX_BUNDLE) {
+        startTransfer(single);
+      } else {
+        sendPacket(single);
+      }
+    } else {
+      bundle.init().startBundle();
+      for (size_t i = start; i < end; i++) {
+        bundle.addMessage(batch[i]);
+      }
+      bundle.endBundle();
+      sendPacket(bundle);
+    }
+    start = end;
+  }
+}
+
+void OscSender::sendPacket(PacketWriter &pw) {
+  if (!sock) {
+    sock.reset(new UdpSocket());
+    sock->connectTo("127.0.0.1", port);
+  }
+  if (!sock->isOk()) {
+    std::cerr << "[OSC Sender] - Error connecting to port " << port << ": " << sock->errorMessage() << "\n";
+    sock.reset();
+    return;
+  }
+  if (!sock->sendPacket(pw.packetData(), pw.packetSize())) {
+    // a connected UDP socket keeps the error from an earlier refused
+    // send, so start again with a fresh one next time
+    std::cerr << "[OSC Sender] - Error sending to port " << port << ": " << sock->errorMessage() << "\n";
+    sock.reset();
+  }
+}
+
+void OscSender::startTransfer(PacketWriter &pw) {
+  if (pw.packetSize() > OSC_CHUNK_SIZE * OSC_MAX_CHUNKS) {
+    std::cerr << "[OSC Sender] - message of " << pw.packetSize() << " bytes is too big to send\n";
+    return;
+  }
+  int id = nextTransferId++;
+  Transfer &transfer = transfers[id];
+  transfer.packet.assign(pw.packetData(), pw.packetData() + pw.packetSize());
+  transfer.checksum = checksum(transfer.packet.data(), transfer.packet.size());
+  transfer.attempts = 0;
+  sendTransfer(id, transfer);
+}
+
+void OscSender::sendTransfer(int id, Transfer &transfer) {
+  size_t size = transfer.packet.size();
+  int count = (int)((size + OSC_CHUNK_SIZE - 1) / OSC_CHUNK_SIZE);
+  Message msg;
+  for (int i = 0; i < count; i++) {
+    size_t offset = i * OSC_CHUNK_SIZE;
+    size_t len = std::min(OSC_CHUNK_SIZE, size - offset);
+    msg.init("/chunk");
+    msg.pushInt32(id);
+    msg.pushInt32(i);
+    msg.pushInt32(count);
+    msg.pushInt32((int32_t)transfer.checksum);
+    msg.pushBlob(&transfer.packet[offset], len);
+    fragment.init().addMessage(msg);
+    sendPacket(fragment);
+  }
+  transfer.attempts++;
+  transfer.sent = std::chrono::steady_clock::now();
+}
+
+void OscSender::handleAcks(std::deque<std::pair<int, bool> > &ack_batch) {
+  for (size_t i = 0; i < ack_batch.size(); i++) {
+    std::map<int, Transfer>::iterator it = transfers.find(ack_batch[i].first);
+    if (it == transfers.end()) continue;
+    if (ack_batch[i].second) {
+      transfers.erase(it);
+    } else {
+      // the server saw every fragment but the checksum didn't match
+      std::cerr << "[OSC Sender] - transfer " << it->first << " was corrupted, sending again\n";
+      sendTransfer(it->first, it->second);
+    }
+  }
+}
+
+void OscSender::retryTransfers() {
+  std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+  std::map<int, Transfer>::iterator it = transfers.begin();
+  while (it != transfers.end()) {
+    if (now - it->second.sent < std::chrono::milliseconds(OSC_TRANSFER_RETRY_MS)) {
+      ++it;
+    } else if (it->second.attempts >= OSC_TRANSFER_MAX_ATTEMPTS) {
+      std::cerr << "[OSC Sender] - giving up on transfer " << it->first << " after " << it->second.attempts << " attempts\n";
+      transfers.erase(it++);
+    } else {
+      sendTransfer(it->first, it->second);
+      ++it;
+    }
   }
+}
 
+// CRC-32 as used by zlib, so the server can check it with Zlib.crc32
+struct Crc32Table
+{
+  uint32_t entries[256];
+  Crc32Table() {
+    for (uint32_t n = 0; n < 256; n++) {
+      uint32_t c = n;
+      for (int k = 0; k < 8; k++) {
+        c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+      }
+      entries[n] = c;
+    }
+  }
+};
+
+uint32_t OscSender::checksum(const void *data, size_t size) {
+  static const Crc32Table table;
+  const unsigned char *p = (const unsigned char *)data;
+  uint32_t crc = 0xFFFFFFFFu;
+  for (size_t i = 0; i < size; i++) {
+    crc = table.entries[(crc ^ p[i]) & 0xFF] ^ (crc >> 8);
+  }
+  return crc ^ 0xFFFFFFFFu;
 }
 
 
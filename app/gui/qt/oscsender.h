@@ -14,19 +14,73 @@
 #ifndef OSCSENDER_H
 #define OSCSENDER_H
 
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+
 #include "oscpkt.hh"
 using namespace oscpkt;
 
+namespace oscpkt { class UdpSocket; }
+
+// Sends messages to the server from a background thread over a single
+// long lived socket. sendOSC only queues the message, and messages
+// queued while a send is in progress go out together as one bundle.
+//
+// Messages too big for one datagram are split into numbered /chunk
+// fragments carrying a CRC32 of the whole packet. The server reassembles
+// them and replies with /chunk/ack, and transfers which are refused or
+// not acknowledged in time are sent again.
 class OscSender
 {
 
 public:
     OscSender(int port);
+    ~OscSender();
     void sendOSC(Message m);
     void bufferNewlineAndIndent(int point_line, int point_index, int first_line, std::string code, std::string fileName, std::string id);
 
+    // may be called from any thread
+    void transferAcked(int id, bool ok);
+
+    static uint32_t checksum(const void *data, size_t size);
+
 private:
+    struct Transfer
+    {
+        std::vector<char> packet;
+        uint32_t checksum;
+        int attempts;
+        std::chrono::steady_clock::time_point sent;
+    };
+
+    void run();
+    void sendBatch(std::deque<Message> &batch);
+    void sendPacket(PacketWriter &pw);
+    void startTransfer(PacketWriter &pw);
+    void sendTransfer(int id, Transfer &transfer);
+    void handleAcks(std::deque<std::pair<int, bool> > &acks);
+    void retryTransfers();
+
     int port;
+    std::unique_ptr<UdpSocket> sock;
+    PacketWriter bundle, single;
+
+    std::mutex queueMutex;
+    std::condition_variable wake;
+    std::deque<Message> queue;
+    std::deque<std::pair<int, bool> > acks;
+    bool running;
+
+    // only touched by the worker thread
+    std::map<int, Transfer> transfers;
+    int nextTransferId;
+    PacketWriter fragment;
+    std::thread worker;
 };
 
 #endif // OSCSENDER_H
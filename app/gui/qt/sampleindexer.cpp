@@ -0,0 +1,169 @@
+//--
+// This file is part of Sonic Pi: http://sonic-pi.net
+// Full project source: https://github.com/samaaron/sonic-pi
+// License: https://github.com/samaaron/sonic-pi/blob/master/LICENSE.md
+//
+// Copyright 2013, 2014, 2015, 2016 by Sam Aaron (http://sam.aaron.name).
+// All rights reserved.
+//
+// Permission is granted for use, copying, modification, and
+// distribution of modified versions of this work as long as this
+// notice is included.
+//++
+
+#include <QDir>
+#include <QFileInfo>
+#include <QRunnable>
+#include <QSet>
+
+#include <iostream>
+
+#include "sampleindexer.h"
+
+namespace {
+  // Lists a single directory on the pool and hands the result back to
+  // the indexer on the GUI thread
+  class ScanTask : public QRunnable
+  {
+  public:
+    ScanTask(SampleIndexer *indexer, const QString &dir, std::atomic<bool> &stopping)
+      : indexer(indexer), dir(dir), stopping(stopping) {}
+
+    void run() {
+      if (stopping) return;
+
+      QStringList names, subdirs;
+      QDir d(dir);
+      QFileInfoList entries = d.entryInfoList(QDir::Files | QDir::Dirs | QDir::NoDotAndDotDot);
+      foreach (const QFileInfo &entry, entries) {
+        if (entry.isDir()) {
+          // links could lead us round in circles
+          if (!entry.isSymLink()) subdirs << entry.absoluteFilePath();
+        } else {
+          QString suffix = entry.suffix().toLower();
+          if (suffix == "wav" || suffix == "wave" || suffix == "aif" || suffix == "aiff" || suffix == "flac") {
+            names << entry.baseName();
+          }
+        }
+      }
+
+      if (stopping) return;
+      QMetaObject::invokeMethod(indexer, "directoryScanned", Qt::QueuedConnection,
+                                Q_ARG(QString, dir), Q_ARG(QStringList, names), Q_ARG(QStringList, subdirs));
+    }
+
+  private:
+    SampleIndexer *indexer;
+    QString dir;
+    std::atomic<bool> &stopping;
+  };
+}
+
+SampleIndexer::SampleIndexer(QObject *parent) : QObject(parent), stopping(false)
+{
+  connect(&watcher, SIGNAL(directoryChanged(const QString&)), this, SLOT(directoryChanged(const QString&)));
+}
+
+SampleIndexer::~SampleIndexer()
+{
+  // results still queued for us are dropped along with this object
+  stopping = true;
+  pool.clear();
+  pool.waitForDone();
+}
+
+void SampleIndexer::addFolder(const QString &path, bool symbols)
+{
+  QString folder = QFileInfo(path).absoluteFilePath();
+  if (folders.contains(folder) || dirs.contains(folder)) return;
+  if (!QFileInfo(folder).isDir()) {
+    std::cout << "[GUI] - sample folder not found: " << folder.toStdString() << std::endl;
+    return;
+  }
+  folders[folder] = symbols;
+  scan(folder, folder);
+}
+
+void SampleIndexer::removeFolder(const QString &path)
+{
+  QString folder = QFileInfo(path).absoluteFilePath();
+  if (!folders.contains(folder)) return;
+
+  QStringList removed;
+  forget(folder, removed);
+  folders.remove(folder);
+  if (!removed.isEmpty()) emit samplesRemoved(removed);
+}
+
+void SampleIndexer::scan(const QString &dir, const QString &root)
+{
+  Directory &d = dirs[dir];
+  d.root = root;
+  watcher.addPath(dir);
+  pool.start(new ScanTask(this, dir, stopping));
+}
+
+void SampleIndexer::directoryChanged(const QString &dir)
+{
+  if (dirs.contains(dir)) {
+    pool.start(new ScanTask(this, dir, stopping));
+  }
+}
+
+void SampleIndexer::directoryScanned(QString dir, QStringList names, QStringList subdirs)
+{
+  // the folder may have been removed while we were listing it
+  if (!dirs.contains(dir)) return;
+  Directory &d = dirs[dir];
+  QString root = d.root;
+
+  bool symbols = folders.value(root);
+  QString open = symbols ? ":" : "\"";
+  QString close = symbols ? "" : "\"";
+  QSet<QString> found;
+  foreach (const QString &name, names) {
+    found.insert(open + name + close);
+  }
+  QSet<QString> known = d.names.toSet();
+
+  QStringList added, removed;
+  foreach (const QString &name, found) {
+    if (!known.contains(name) && nameCounts[name]++ == 0) added << name;
+  }
+  foreach (const QString &name, known) {
+    if (!found.contains(name) && --nameCounts[name] == 0) {
+      nameCounts.remove(name);
+      removed << name;
+    }
+  }
+  d.names = found.toList();
+
+  QStringList oldSubdirs = d.subdirs;
+  d.subdirs = subdirs;
+  // d is not used past here as scan and forget change dirs
+  foreach (const QString &sub, oldSubdirs) {
+    if (!subdirs.contains(sub)) forget(sub, removed);
+  }
+  foreach (const QString &sub, subdirs) {
+    if (!dirs.contains(sub)) scan(sub, root);
+  }
+
+  if (!added.isEmpty()) emit samplesAdded(added);
+  if (!removed.isEmpty()) emit samplesRemoved(removed);
+}
+
+void SampleIndexer::forget(const QString &dir, QStringList &removed)
+{
+  if (!dirs.contains(dir)) return;
+  Directory d = dirs.take(dir);
+  watcher.removePath(dir);
+  foreach (const QString &name, d.names) {
+    if (--nameCounts[name] == 0) {
+      nameCounts.remove(name);
+      removed << name;
+    }
+  }
+  foreach (const QString &sub, d.subdirs) {
+    forget(sub, removed);
+  }
+}
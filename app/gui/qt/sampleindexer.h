@@ -0,0 +1,74 @@
+//--
+// This file is part of Sonic Pi: http://sonic-pi.net
+// Full project source: https://github.com/samaaron/sonic-pi
+// License: https://github.com/samaaron/sonic-pi/blob/master/LICENSE.md
+//
+// Copyright 2013, 2014, 2015, 2016 by Sam Aaron (http://sam.aaron.name).
+// All rights reserved.
+//
+// Permission is granted for use, copying, modification, and
+// distribution of modified versions of this work as long as this
+// notice is included.
+//++
+
+#ifndef SAMPLEINDEXER_H
+#define SAMPLEINDEXER_H
+
+#include <QObject>
+#include <QHash>
+#include <QStringList>
+#include <QThreadPool>
+#include <QFileSystemWatcher>
+
+#include <atomic>
+
+// Finds the names of the samples in a set of folders and their
+// subfolders for autocompletion. Each directory is listed by a task on a
+// thread pool so startup never waits on the disk, and directories are
+// watched so samples added or removed later are picked up too.
+//
+// Samples in symbol folders (the built-in ones) are reported as :name,
+// the rest as "name", matching how they are passed to sample.
+class SampleIndexer : public QObject
+{
+  Q_OBJECT
+
+public:
+  explicit SampleIndexer(QObject *parent = 0);
+  ~SampleIndexer();
+
+  void addFolder(const QString &path, bool symbols);
+  void removeFolder(const QString &path);
+
+signals:
+  void samplesAdded(QStringList names);
+  void samplesRemoved(QStringList names);
+
+private slots:
+  void directoryScanned(QString dir, QStringList names, QStringList subdirs);
+  void directoryChanged(const QString &dir);
+
+private:
+  struct Directory {
+    QString root;
+    QStringList names;
+    QStringList subdirs;
+  };
+
+  void scan(const QString &dir, const QString &root);
+  void forget(const QString &dir, QStringList &removed);
+
+  QThreadPool pool;
+  std::atomic<bool> stopping;
+  QFileSystemWatcher watcher;
+
+  // folder => whether its samples are symbols
+  QHash<QString, bool> folders;
+  // every directory found so far under one of the folders
+  QHash<QString, Directory> dirs;
+  // how many directories hold a sample of each name, so a name is only
+  // removed once the last of them has gone
+  QHash<QString, int> nameCounts;
+};
+
+#endif
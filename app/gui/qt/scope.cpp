@@ -15,12 +15,19 @@
 
 #include <QPaintEvent>
 #include <QResizeEvent>
+#include <QShowEvent>
+#include <QHideEvent>
+#include <QGuiApplication>
+#include <QScreen>
+#include <QWindow>
 #include <QVBoxLayout>
 #include <QIcon>
 #include <QTimer>
 #include <QPainter>
 #include <QDebug>
 #include <qwt_text_label.h>
+#include <qwt_scale_engine.h>
+#include <algorithm>
 #include <cmath>
 #include <set>
 #if (QT_VERSION >= 0x050400) || !defined(Q_OS_LINUX)
@@ -29,7 +36,143 @@
   #include <qwt_plot_glcanvas.h>
 #endif
 
-ScopeBase::ScopeBase( const QString& name, const QString& title, QWidget* parent ) : QWidget(parent), name(name), title(title), defaultShowX(true), defaultShowY(true), plot(QwtText(name),this)
+const unsigned int ScopeHistory::Size;
+
+ScopeHistory::ScopeHistory() : head(0), downmix(scopeDownmixKernel().fn)
+{
+  clear();
+}
+
+void ScopeHistory::clear()
+{
+  for( unsigned int c = 0; c < NumChannels; ++c )
+  {
+    std::fill_n(samples[c],Size,0);
+  }
+  head = 0;
+}
+
+void ScopeHistory::push( const float* left, const float* right, unsigned int frames )
+{
+  // only the newest Size frames can ever be displayed
+  if( frames > Size )
+  {
+    left += frames - Size;
+    right += frames - Size;
+    frames = Size;
+  }
+
+  // the new frames wrap around the end of the ring at most once
+  unsigned int first = std::min( frames, Size - head );
+  downmix( left, right, samples[Left] + head, samples[Right] + head, samples[Mono] + head, first );
+  downmix( left + first, right + first, samples[Left], samples[Right], samples[Mono], frames - first );
+  head = (head + frames) & (Size - 1);
+}
+
+size_t ScopeSeries::size() const
+{
+  return points.size();
+}
+
+QPointF ScopeSeries::sample( size_t i ) const
+{
+  return points[i];
+}
+
+ScopeSeriesData::ScopeSeriesData( const ScopeHistory& history, int xChannel, int yChannel, unsigned int count ) : history(history), xChannel(xChannel), yChannel(yChannel), count(count), offset(ScopeHistory::Size - count)
+{
+}
+
+void ScopeSeriesData::rebuild( unsigned int width )
+{
+  points.clear();
+
+  if( xChannel >= 0 || width == 0 || count <= 2 * width )
+  {
+    points.reserve( count );
+    for( unsigned int i = 0; i < count; ++i )
+    {
+      double x = xChannel < 0 ? i : history.value( xChannel, offset + i );
+      points.push_back( QPointF( x, history.value( yChannel, offset + i ) ) );
+    }
+    return;
+  }
+
+  // keep the extremes of every pixel column in the order they occurred
+  // so peaks survive and the trace still reads left to right
+  points.reserve( 2 * width );
+  for( unsigned int col = 0; col < width; ++col )
+  {
+    unsigned int start = (unsigned long)col * count / width;
+    unsigned int end = (unsigned long)(col + 1) * count / width;
+    unsigned int minIdx = start, maxIdx = start;
+    double minVal = history.value( yChannel, offset + start );
+    double maxVal = minVal;
+    for( unsigned int i = start + 1; i < end; ++i )
+    {
+      double v = history.value( yChannel, offset + i );
+      if( v < minVal ) { minVal = v; minIdx = i; }
+      if( v > maxVal ) { maxVal = v; maxIdx = i; }
+    }
+    if( minIdx <= maxIdx )
+    {
+      points.push_back( QPointF( minIdx, minVal ) );
+      points.push_back( QPointF( maxIdx, maxVal ) );
+    } else
+    {
+      points.push_back( QPointF( maxIdx, maxVal ) );
+      points.push_back( QPointF( minIdx, minVal ) );
+    }
+  }
+}
+
+
+QRectF ScopeSeriesData::boundingRect() const
+{
+  // the scope axes are fixed so there is no need to scan the samples
+  if( xChannel < 0 )
+  {
+    return QRectF( 0, -1, count, 2 );
+  }
+  return QRectF( -1, -1, 2, 2 );
+}
+
+SpectrumSeriesData::SpectrumSeriesData( const ScopeSpectrum& spectrum ) : spectrum(spectrum)
+{
+}
+
+void SpectrumSeriesData::rebuild( unsigned int width )
+{
+  const float* mags = spectrum.magnitudes();
+  const unsigned int last = ScopeSpectrum::Bins - 1;
+  const double logLast = std::log( (double)last );
+  points.clear();
+  points.reserve( std::min( last, std::max( width, 1u ) ) );
+
+  // bins are spread logarithmically, so low bins get a column each and
+  // high bins share one; keep the loudest bin of each column. DC is
+  // skipped as it can't be shown on a log axis.
+  int column = -1;
+  for( unsigned int k = 1; k <= last; ++k )
+  {
+    int c = (int)(width * std::log( (double)k ) / logLast);
+    if( c != column || points.empty() )
+    {
+      points.push_back( QPointF( k, mags[k] ) );
+      column = c;
+    } else if( mags[k] > points.back().y() )
+    {
+      points.back() = QPointF( k, mags[k] );
+    }
+  }
+}
+
+QRectF SpectrumSeriesData::boundingRect() const
+{
+  return QRectF( 1, -100, ScopeSpectrum::Bins - 2, 100 );
+}
+
+ScopeBase::ScopeBase( const QString& name, const QString& title, QWidget* parent ) : QWidget(parent), name(name), title(title), defaultShowX(true), defaultShowY(true), decimatedWidth(-1), dirty(true), plot(QwtText(name),this)
 {
   QSizePolicy sp(QSizePolicy::MinimumExpanding,QSizePolicy::Expanding);
   plot.setSizePolicy(sp);
@@ -52,6 +195,7 @@ void ScopeBase::setYRange( float min, float max, bool showLabel )
   plot.setAxisScale( QwtPlot::Axis::yLeft, min, max );
   plot.enableAxis( QwtPlot::Axis::yLeft, showLabel );
   defaultShowY = showLabel;
+  invalidate();
 }
 
 void ScopeBase::setXRange( float min, float max, bool showLabel )
@@ -59,6 +203,7 @@ void ScopeBase::setXRange( float min, float max, bool showLabel )
   plot.setAxisScale( QwtPlot::Axis::xBottom, min, max );
   plot.enableAxis( QwtPlot::Axis::xBottom, showLabel );
   defaultShowX = showLabel;
+  invalidate();
 }
 
 bool ScopeBase::setAxesVisible(bool b)
@@ -72,16 +217,46 @@ bool ScopeBase::setAxesVisible(bool b)
   {
     plot.setTitle(QwtText(""));
   }
+  invalidate();
   return b;
 }
 
-void ScopeBase::refresh( )
+void ScopeBase::addSeries( ScopeSeries* data )
 {
+  series.push_back( data );
+}
+
+void ScopeBase::refresh( bool newFrames )
+{
+  dirty = hasNewData( newFrames ) || dirty;
   if( !plot.isVisible() ) return;
-  plot.replot();
+
+  // only redo the decimation when there is something new to show or
+  // the canvas has changed size
+  int width = plot.canvas()->width();
+  if( dirty || width != decimatedWidth )
+  {
+    for( auto s : series )
+    {
+      s->rebuild( width );
+    }
+    decimatedWidth = width;
+    dirty = false;
+    plot.replot();
+  }
+}
+
+void ScopeBase::invalidate()
+{
+  dirty = true;
+}
+
+bool ScopeBase::hasNewData( bool newFrames )
+{
+  return newFrames;
 }
 
-ScopePanel::ScopePanel( const QString& name, const QString& title, double* sample_x, double* sample_y, int num_samples, QWidget* parent ) : ScopeBase(name,title,parent)
+ScopePanel::ScopePanel( const QString& name, const QString& title, const ScopeHistory& history, int xChannel, int yChannel, unsigned int num_samples, QWidget* parent ) : ScopeBase(name,title,parent)
 {
 
 #if defined(Q_OS_WIN)
@@ -95,7 +270,9 @@ ScopePanel::ScopePanel( const QString& name, const QString& title, double* sampl
   plot_curve.setPaintAttribute( QwtPlotCurve::PaintAttribute::FilterPoints );
 #endif
 
-  plot_curve.setRawSamples( sample_x, sample_y, num_samples );
+  ScopeSeriesData* data = new ScopeSeriesData( history, xChannel, yChannel, num_samples );
+  plot_curve.setData( data );
+  addSeries( data );
   setXRange( 0, num_samples, false );
   setYRange( -1, 1, true );
   setPen(QPen(QColor("deeppink"), 2));
@@ -106,9 +283,45 @@ ScopePanel::ScopePanel( const QString& name, const QString& title, double* sampl
 void ScopePanel::setPen( QPen pen )
 {
   plot_curve.setPen( pen );
+  invalidate();
+}
+
+SpectrumPanel::SpectrumPanel( const QString& name, const QString& title, ScopeSpectrum& spectrum, QWidget* parent ) : ScopeBase(name,title,parent), spectrum(spectrum)
+{
+#if defined(Q_OS_WIN)
+  plot.setCanvas( new QwtPlotGLCanvas() );
+#endif
+
+#if QWT_VERSION >= 0x60100
+  plot.setAxisScaleEngine( QwtPlot::Axis::xBottom, new QwtLogScaleEngine() );
+#else
+  plot.setAxisScaleEngine( QwtPlot::Axis::xBottom, new QwtLog10ScaleEngine() );
+#endif
+
+  SpectrumSeriesData* data = new SpectrumSeriesData( spectrum );
+  plot_curve.setData( data );
+  addSeries( data );
+  setXRange( 1, ScopeSpectrum::Bins - 1, false );
+  setYRange( -100, 0, true );
+  setPen(QPen(QColor("deeppink"), 1));
+
+  plot_curve.attach(&plot);
+}
+
+void SpectrumPanel::setPen( QPen pen )
+{
+  plot_curve.setPen( pen );
+  invalidate();
+}
+
+bool SpectrumPanel::hasNewData( bool newFrames )
+{
+  // the spectrum is computed off the GUI thread so it arrives on its
+  // own schedule rather than with the frames
+  return spectrum.poll();
 }
 
-MultiScopePanel::MultiScopePanel( const QString& name, const QString& title, double* sample_x, double samples_y[][4096], unsigned int num_lines, unsigned int num_samples, QWidget* parent ) : ScopeBase(name,title,parent)
+MultiScopePanel::MultiScopePanel( const QString& name, const QString& title, const ScopeHistory& history, unsigned int num_lines, unsigned int num_samples, QWidget* parent ) : ScopeBase(name,title,parent)
 {
   for( unsigned int i = 0; i < num_lines; ++i )
   {
@@ -117,7 +330,9 @@ MultiScopePanel::MultiScopePanel( const QString& name, const QString& title, dou
   curve->setPaintAttribute( QwtPlotCurve::PaintAttribute::FilterPoints );
 #endif
 
-    curve->setRawSamples( sample_x, samples_y[i], 4096 );
+    ScopeSeriesData* data = new ScopeSeriesData( history, -1, i, num_samples );
+    curve->setData( data );
+    addSeries( data );
     curve->attach(&plot);
     curves.push_back( std::shared_ptr<QwtPlotCurve>(curve) );
   }
@@ -133,25 +348,48 @@ void MultiScopePanel::setPen( QPen pen )
   {
     c.get()->setPen(pen);
   }
+  invalidate();
 }
 
-Scope::Scope( QWidget* parent ) : QWidget(parent), paused( false ), emptyFrames(0)
+// Polling intervals (ms) used when no audio is flowing through the
+// scope and when scsynth's shared memory isn't available yet. While
+// audio is flowing we poll at the display refresh rate instead.
+static const int SCOPE_IDLE_INTERVAL = 250;
+static const int SCOPE_RECONNECT_INTERVAL = 1000;
+// consecutive empty polls before we consider the scope idle
+static const unsigned int SCOPE_IDLE_POLLS = 10;
+
+Scope::Scope( int scsynthPort, const std::vector<unsigned int>& scopeBuffers, QWidget* parent ) : QWidget(parent), scsynthPort(scsynthPort), paused( false ), emptyFrames(0)
 {
-  std::fill_n(sample[0],4096,0);
-  std::fill_n(sample[1],4096,0);
-  std::fill_n(sample_mono,4096,0);
-  panels.push_back( std::shared_ptr<ScopePanel>(new ScopePanel("Lissajous", "Lissajous", sample[0]+(4096-1024), sample[1]+(4096-1024), 1024, this ) ) );
-  panels.push_back( std::shared_ptr<ScopePanel>(new ScopePanel("Stereo", "Left", sample_x,sample[0],4096,this) ) );
-  panels.push_back( std::shared_ptr<ScopePanel>(new ScopePanel("Stereo", "Right", sample_x,sample[1],4096, this) ) );
-//  panels.push_back( std::shared_ptr<MultiScopePanel>(new MultiScopePanel("Stereo",sample_x,sample,2,4096,this) ) );
-  panels.push_back( std::shared_ptr<ScopePanel>(new ScopePanel("Mono", "Mono", sample_x,sample_mono,4096, this) ) );
+  for( unsigned int index : scopeBuffers.empty() ? std::vector<unsigned int>(1, 0) : scopeBuffers )
+  {
+    ScopeSource* source = new ScopeSource();
+    source->index = index;
+    sources.push_back( std::unique_ptr<ScopeSource>(source) );
+  }
+  const ScopeHistory& history = sources[0]->history;
+
+  panels.push_back( std::shared_ptr<ScopePanel>(new ScopePanel("Lissajous", "Lissajous", history, ScopeHistory::Left, ScopeHistory::Right, 1024, this ) ) );
+  panels.push_back( std::shared_ptr<ScopePanel>(new ScopePanel("Stereo", "Left", history, -1, ScopeHistory::Left, ScopeHistory::Size, this) ) );
+  panels.push_back( std::shared_ptr<ScopePanel>(new ScopePanel("Stereo", "Right", history, -1, ScopeHistory::Right, ScopeHistory::Size, this) ) );
+//  panels.push_back( std::shared_ptr<MultiScopePanel>(new MultiScopePanel("Stereo","Stereo",history,2,ScopeHistory::Size,this) ) );
+  panels.push_back( std::shared_ptr<ScopePanel>(new ScopePanel("Mono", "Mono", history, -1, ScopeHistory::Mono, ScopeHistory::Size, this) ) );
   panels[0]->setPen(QPen(QColor("deeppink"), 1));
   panels[0]->setXRange( -1, 1, true );
 
-  for( unsigned int i = 0; i < 4096; ++i ) sample_x[i] = i;
-  QTimer *scopeTimer = new QTimer(this);
+  spectrumPanel = std::shared_ptr<SpectrumPanel>(new SpectrumPanel("Spectrum", "Spectrum", spectrum, this) );
+  panels.push_back( spectrumPanel );
+
+  // any further scope buffers get a mono panel of their own
+  for( unsigned int i = 1; i < sources.size(); ++i )
+  {
+    QString title = QString("Buffer %1").arg(sources[i]->index);
+    panels.push_back( std::shared_ptr<ScopePanel>(new ScopePanel("Buffers", title, sources[i]->history, -1, ScopeHistory::Mono, ScopeHistory::Size, this) ) );
+  }
+
+  scopeTimer = new QTimer(this);
+  scopeTimer->setTimerType(Qt::PreciseTimer);
   connect(scopeTimer, SIGNAL(timeout()), this, SLOT(drawLoop()));
-  scopeTimer->start(20);
 
   QVBoxLayout* layout = new QVBoxLayout();
   layout->setSpacing(0);
@@ -201,82 +439,176 @@ bool Scope::setScopeAxes(bool on)
 }
 
 void Scope::togglePause() {
-  paused = !paused;
+  if( paused )
+  {
+    resume();
+  } else
+  {
+    pause();
+  }
 }
 
 void Scope::pause() {
   paused = true;
+  scopeTimer->stop();
 }
 
 void Scope::resume() {
   paused = false;
+  emptyFrames = 0;
+  if( isVisible() )
+  {
+    schedule();
+  }
+}
+
+void Scope::showEvent( QShowEvent* event )
+{
+  QWidget::showEvent( event );
+  if( !paused )
+  {
+    schedule();
+  }
+}
+
+void Scope::hideEvent( QHideEvent* event )
+{
+  QWidget::hideEvent( event );
+  scopeTimer->stop();
 }
 
 void Scope::resetScope()
 {
-  shmClient.reset(new server_shared_memory_client(4556));
-  shmReader = shmClient->get_scope_buffer_reader(0);
+  for( auto& source : sources )
+  {
+    source->reader = scope_buffer_reader();
+  }
+  shmClient.reset();
+  emptyFrames = 0;
+  connectSharedMemory();
 }
 
-void Scope::refresh() {
-  if( !shmReader.valid() )
+bool Scope::connectSharedMemory()
+{
+  // the segment only goes away if scsynth does, so once we have it we
+  // keep it and just wait for the scope buffers to be initialised
+  if( !shmClient )
+  {
+    try
+    {
+      shmClient.reset(new server_shared_memory_client(scsynthPort));
+    } catch( const std::exception& )
+    {
+      return false;
+    }
+  }
+  for( auto& source : sources )
   {
-    resetScope();
+    if( !source->reader.valid() )
+    {
+      source->reader = shmClient->get_scope_buffer_reader(source->index);
+    }
   }
+  return connected();
+}
 
-  unsigned int frames;
-  if( shmReader.pull( frames ) )
+bool Scope::connected()
+{
+  for( auto& source : sources )
   {
-    emptyFrames = 0;
-    float* data = shmReader.data();
-    for( unsigned int j = 0; j < 2; ++j )
+    if( source->reader.valid() ) return true;
+  }
+  return false;
+}
+
+bool Scope::pullFrames()
+{
+  if( !connected() && !connectSharedMemory() )
+  {
+    return false;
+  }
+
+  bool any = false;
+  for( auto& source : sources )
+  {
+    scope_buffer_reader& reader = source->reader;
+    unsigned int frames;
+    if( !reader.valid() || !reader.pull( frames ) ) continue;
+
+    float* left = reader.data();
+    float* right = reader.channels() > 1 ? left + reader.max_frames() : left;
+    source->history.push( left, right, frames );
+    if( source == sources[0] && spectrumPanel->isVisible() )
     {
-      unsigned int offset = shmReader.max_frames() * j;
-      for( unsigned int i = 0; i < 4096 - frames; ++i )
-      {
-        sample[j][i] = sample[j][i+frames];
-        if( j == 0 )
-        {
-          sample_mono[i] = sample_mono[i+frames];
-        }
-      }
-
-      for( unsigned int i = 0; i < frames; ++i )
-      {
-        sample[j][4096-frames+i] = data[i+offset];
-        auto d = data[i+offset] + 1.0;
-        if(j == 0)
-        {
-          sample_mono[4096-frames+i] = d*d;
-        } else
-        {
-          sample_mono[4096-frames+i] += d*d;
-          sample_mono[4096-frames+i] /= 2.0f;
-          sample_mono[4096-frames+i] = sqrt(sample_mono[4096-frames+i]) - 1.0;
-        }
-      }
+      spectrum.push( left, right, frames );
     }
+    any = true;
+  }
+
+  if( any )
+  {
+    emptyFrames = 0;
   } else
   {
     ++emptyFrames;
-    if( emptyFrames > 10 )
+    if( emptyFrames > SCOPE_IDLE_POLLS )
     {
-      resetScope();
-      emptyFrames = 0;
+      // pick up any scope buffers that weren't set up when we connected
+      connectSharedMemory();
     }
   }
+  return any;
+}
 
-  for( auto scope : panels )
+int Scope::frameInterval()
+{
+  QWindow* win = window()->windowHandle();
+  QScreen* screen = win ? win->screen() : QGuiApplication::primaryScreen();
+  qreal hz = screen ? screen->refreshRate() : 60;
+  if( hz < 1 ) hz = 60;
+  return std::max( 1, (int)(1000.0 / hz) );
+}
+
+void Scope::schedule()
+{
+  int interval;
+  if( !connected() )
+  {
+    interval = SCOPE_RECONNECT_INTERVAL;
+  } else if( emptyFrames > SCOPE_IDLE_POLLS )
+  {
+    interval = SCOPE_IDLE_INTERVAL;
+  } else
+  {
+    interval = frameInterval();
+  }
+
+  if( !scopeTimer->isActive() || scopeTimer->interval() != interval )
   {
-    scope->refresh();
+    scopeTimer->start( interval );
   }
 }
 
+void Scope::refresh() {
+  for( auto scope : panels )
+  {
+    scope->invalidate();
+    scope->refresh( false );
+  }
+}
 
 void Scope::drawLoop() {
   // short circuit if possible
-  if( paused ) return;
-  if( !isVisible() ) return;
+  if( paused || !isVisible() )
+  {
+    scopeTimer->stop();
+    return;
+  }
 
-  refresh();
+  bool newFrames = pullFrames();
+  for( auto scope : panels )
+  {
+    scope->refresh( newFrames );
+  }
+  schedule();
 }
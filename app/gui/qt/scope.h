@@ -17,13 +17,95 @@
 #include <QWidget>
 #include <qwt_plot.h>
 #include <qwt_plot_curve.h>
+#include <qwt_series_data.h>
 
 #include <server_shm.hpp>
+#include "scope_dsp.h"
+#include "scope_spectrum.h"
 #include <memory>
 #include <string>
+#include <vector>
 
 class QPaintEvent;
 class QResizeEvent;
+class QShowEvent;
+class QHideEvent;
+class QTimer;
+
+// Fixed length circular history of scope samples. Incoming frames
+// overwrite the oldest samples in place and `head` tracks where the
+// oldest sample now lives, so appending costs O(frames) rather than
+// shifting the whole history on every refresh.
+class ScopeHistory
+{
+public:
+  static const unsigned int Size = 4096;
+  enum Channel { Left = 0, Right, Mono, NumChannels };
+
+  ScopeHistory();
+
+  void clear();
+  void push( const float* left, const float* right, unsigned int frames );
+
+  // i == 0 is the oldest sample, i == Size - 1 the newest
+  inline double value( unsigned int channel, unsigned int i ) const
+  {
+    return samples[channel][(head + i) & (Size - 1)];
+  }
+
+private:
+  double samples[NumChannels][Size];
+  unsigned int head;
+  scope_downmix_fn downmix;
+};
+
+// Points handed to a scope curve. ScopeBase calls rebuild() with the
+// canvas width whenever there is new data or the canvas was resized,
+// and Qwt then only ever reads the prepared points.
+class ScopeSeries : public QwtSeriesData<QPointF>
+{
+public:
+  virtual void rebuild( unsigned int width ) = 0;
+
+  size_t size() const;
+  QPointF sample( size_t i ) const;
+
+protected:
+  std::vector<QPointF> points;
+};
+
+// Presents the newest `count` samples of a ScopeHistory channel to Qwt.
+// With xChannel < 0 the x value is the sample index and rebuild()
+// reduces the samples to a min/max pair per pixel column, so Qwt never
+// walks more than 2 x width points. Otherwise the x value is read from
+// that channel (used by Lissajous) and every sample is kept.
+class ScopeSeriesData : public ScopeSeries
+{
+public:
+  ScopeSeriesData( const ScopeHistory& history, int xChannel, int yChannel, unsigned int count );
+
+  void rebuild( unsigned int width );
+  QRectF boundingRect() const;
+
+private:
+  const ScopeHistory& history;
+  int xChannel, yChannel;
+  unsigned int count, offset;
+};
+
+// Spectrum magnitudes (dB) against bin number on a log x axis, keeping
+// the loudest bin per pixel column.
+class SpectrumSeriesData : public ScopeSeries
+{
+public:
+  SpectrumSeriesData( const ScopeSpectrum& spectrum );
+
+  void rebuild( unsigned int width );
+  QRectF boundingRect() const;
+
+private:
+  const ScopeSpectrum& spectrum;
+};
 
 class ScopeBase : public QWidget
 {
@@ -35,7 +117,10 @@ public:
   const QString& getName();
   virtual void setPen( QPen pen ) = 0;
 
-  void refresh();
+  void refresh( bool newFrames );
+  void invalidate();
+  // whether the panel has something new to draw, defaults to newFrames
+  virtual bool hasNewData( bool newFrames );
   void setXRange( float min, float max, bool showLabel = true );
   void setYRange( float min, float max, bool showLabel = true );
   bool setAxesVisible( bool on );
@@ -43,8 +128,14 @@ public:
 private:
   QString name,title;
   bool defaultShowX, defaultShowY;
+  std::vector<ScopeSeries*> series;
+  int decimatedWidth;
+  bool dirty;
 
 protected:
+  // series are owned by their curves, we only rebuild them
+  void addSeries( ScopeSeries* data );
+
   QwtPlot plot;
 };
 
@@ -52,7 +143,7 @@ protected:
 class ScopePanel : public ScopeBase
 {
 public:
-  ScopePanel( const QString& name, const QString& title, double* sample_x, double* sample_y, int num_samples, QWidget* parent = 0 );
+  ScopePanel( const QString& name, const QString& title, const ScopeHistory& history, int xChannel, int yChannel, unsigned int num_samples, QWidget* parent = 0 );
 
   void setPen( QPen pen );
 
@@ -61,10 +152,24 @@ private:
 };
 
 
+class SpectrumPanel : public ScopeBase
+{
+public:
+  SpectrumPanel( const QString& name, const QString& title, ScopeSpectrum& spectrum, QWidget* parent = 0 );
+
+  void setPen( QPen pen );
+  bool hasNewData( bool newFrames );
+
+private:
+  ScopeSpectrum& spectrum;
+  QwtPlotCurve plot_curve;
+};
+
+
 class MultiScopePanel : public ScopeBase
 {
 public:
-  MultiScopePanel( const QString& name, const QString& title, double* sample_x, double samples_y[][4096], unsigned int num_lines, unsigned int num_samples, QWidget* parent );
+  MultiScopePanel( const QString& name, const QString& title, const ScopeHistory& history, unsigned int num_lines, unsigned int num_samples, QWidget* parent );
 
   void setPen( QPen pen );
 
@@ -73,12 +178,22 @@ private:
 };
 
 
+// One scsynth scope buffer the GUI is reading from
+struct ScopeSource
+{
+  unsigned int index;
+  scope_buffer_reader reader;
+  ScopeHistory history;
+};
+
 class Scope : public QWidget
 {
   Q_OBJECT
 
 public:
-  Scope( QWidget* parent = 0 );
+  // scopeBuffers lists the scsynth scope buffers to read, the first of
+  // which drives the standard panels and the spectrum
+  Scope( int scsynthPort, const std::vector<unsigned int>& scopeBuffers = std::vector<unsigned int>(1, 0), QWidget* parent = 0 );
   virtual ~Scope();
 
   std::vector<QString> getScopeNames() const;
@@ -87,19 +202,31 @@ public:
   void togglePause();
   void pause();
   void resume();
+  // reopen scsynth's shared memory, e.g. after scsynth has booted
   void resetScope();
   void refresh();
 
+protected:
+  void showEvent( QShowEvent* event );
+  void hideEvent( QHideEvent* event );
+
 private slots:
   void drawLoop();
 
 private:
+  bool connectSharedMemory();
+  bool connected();
+  bool pullFrames();
+  void schedule();
+  int frameInterval();
+
   std::unique_ptr<server_shared_memory_client> shmClient;
-  double sample_x[4096];
-  double sample[2][4096];
-  double sample_mono[4096];
-  scope_buffer_reader shmReader;
+  std::vector<std::unique_ptr<ScopeSource>> sources;
+  ScopeSpectrum spectrum;
   std::vector<std::shared_ptr<ScopeBase>> panels;
+  std::shared_ptr<ScopeBase> spectrumPanel;
+  QTimer* scopeTimer;
+  int scsynthPort;
   bool paused;
   unsigned int emptyFrames;
 };
@@ -0,0 +1,208 @@
+//--
+// This file is part of Sonic Pi: http://sonic-pi.net
+// Full project source: https://github.com/samaaron/sonic-pi
+// License: https://github.com/samaaron/sonic-pi/blob/master/LICENSE.md
+//
+// Copyright 2013, 2014, 2015, 2016 by Sam Aaron (http://sam.aaron.name).
+// All rights reserved.
+//
+// Permission is granted for use, copying, modification, and
+// distribution of modified versions of this work as long as this
+// notice is included.
+//++
+
+#include "scope_dsp.h"
+
+#include <cmath>
+
+#if defined(__x86_64__) || defined(_M_X64) || (defined(__SSE2__) && defined(__i386__)) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+  #define SCOPE_DSP_SSE2
+  #include <emmintrin.h>
+  #if defined(_MSC_VER)
+    #include <intrin.h>
+    #include <immintrin.h>
+    #define SCOPE_DSP_AVX2
+    #define SCOPE_DSP_TARGET_AVX2
+  #elif defined(__GNUC__)
+    #include <immintrin.h>
+    #define SCOPE_DSP_AVX2
+    #define SCOPE_DSP_TARGET_AVX2 __attribute__((target("avx2")))
+  #endif
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+  // NEON is part of the baseline on AArch64, and on 32 bit ARM it is
+  // only available when the whole build targets it, so there is
+  // nothing to detect at runtime.
+  #define SCOPE_DSP_NEON
+  #include <arm_neon.h>
+#endif
+
+// All kernels do the arithmetic in single precision, which is what
+// scsynth hands us anyway, so the results match across kernels.
+static void downmixScalar( const float* left, const float* right,
+                           double* out_left, double* out_right, double* out_mono,
+                           unsigned int frames )
+{
+  for( unsigned int i = 0; i < frames; ++i )
+  {
+    float l = left[i] + 1.0f;
+    float r = right[i] + 1.0f;
+    out_left[i] = left[i];
+    out_right[i] = right[i];
+    out_mono[i] = std::sqrt((l * l + r * r) * 0.5f) - 1.0f;
+  }
+}
+
+#ifdef SCOPE_DSP_SSE2
+static void downmixSSE2( const float* left, const float* right,
+                         double* out_left, double* out_right, double* out_mono,
+                         unsigned int frames )
+{
+  const __m128 one = _mm_set1_ps(1.0f);
+  const __m128 half = _mm_set1_ps(0.5f);
+  unsigned int i = 0;
+  for( ; i + 4 <= frames; i += 4 )
+  {
+    __m128 l = _mm_loadu_ps(left + i);
+    __m128 r = _mm_loadu_ps(right + i);
+    __m128 lp = _mm_add_ps(l, one);
+    __m128 rp = _mm_add_ps(r, one);
+    __m128 m = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(lp, lp), _mm_mul_ps(rp, rp)), half);
+    m = _mm_sub_ps(_mm_sqrt_ps(m), one);
+
+    _mm_storeu_pd(out_left + i, _mm_cvtps_pd(l));
+    _mm_storeu_pd(out_left + i + 2, _mm_cvtps_pd(_mm_movehl_ps(l, l)));
+    _mm_storeu_pd(out_right + i, _mm_cvtps_pd(r));
+    _mm_storeu_pd(out_right + i + 2, _mm_cvtps_pd(_mm_movehl_ps(r, r)));
+    _mm_storeu_pd(out_mono + i, _mm_cvtps_pd(m));
+    _mm_storeu_pd(out_mono + i + 2, _mm_cvtps_pd(_mm_movehl_ps(m, m)));
+  }
+  downmixScalar(left + i, right + i, out_left + i, out_right + i, out_mono + i, frames - i);
+}
+#endif
+
+#ifdef SCOPE_DSP_AVX2
+SCOPE_DSP_TARGET_AVX2
+static void downmixAVX2( const float* left, const float* right,
+                         double* out_left, double* out_right, double* out_mono,
+                         unsigned int frames )
+{
+  const __m256 one = _mm256_set1_ps(1.0f);
+  const __m256 half = _mm256_set1_ps(0.5f);
+  unsigned int i = 0;
+  for( ; i + 8 <= frames; i += 8 )
+  {
+    __m256 l = _mm256_loadu_ps(left + i);
+    __m256 r = _mm256_loadu_ps(right + i);
+    __m256 lp = _mm256_add_ps(l, one);
+    __m256 rp = _mm256_add_ps(r, one);
+    __m256 m = _mm256_mul_ps(_mm256_add_ps(_mm256_mul_ps(lp, lp), _mm256_mul_ps(rp, rp)), half);
+    m = _mm256_sub_ps(_mm256_sqrt_ps(m), one);
+
+    _mm256_storeu_pd(out_left + i, _mm256_cvtps_pd(_mm256_castps256_ps128(l)));
+    _mm256_storeu_pd(out_left + i + 4, _mm256_cvtps_pd(_mm256_extractf128_ps(l, 1)));
+    _mm256_storeu_pd(out_right + i, _mm256_cvtps_pd(_mm256_castps256_ps128(r)));
+    _mm256_storeu_pd(out_right + i + 4, _mm256_cvtps_pd(_mm256_extractf128_ps(r, 1)));
+    _mm256_storeu_pd(out_mono + i, _mm256_cvtps_pd(_mm256_castps256_ps128(m)));
+    _mm256_storeu_pd(out_mono + i + 4, _mm256_cvtps_pd(_mm256_extractf128_ps(m, 1)));
+  }
+  downmixSSE2(left + i, right + i, out_left + i, out_right + i, out_mono + i, frames - i);
+}
+
+static bool cpuHasAVX2()
+{
+#if defined(_MSC_VER)
+  int info[4];
+  __cpuid(info, 0);
+  if( info[0] < 7 ) return false;
+  __cpuid(info, 1);
+  bool osxsave = (info[2] & (1 << 27)) != 0;
+  bool avx = (info[2] & (1 << 28)) != 0;
+  if( !osxsave || !avx ) return false;
+  // the OS must also save the YMM registers on a context switch
+  if( (_xgetbv(0) & 0x6) != 0x6 ) return false;
+  __cpuidex(info, 7, 0);
+  return (info[1] & (1 << 5)) != 0;
+#else
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("avx2");
+#endif
+}
+#endif
+
+#ifdef SCOPE_DSP_NEON
+static void downmixNEON( const float* left, const float* right,
+                         double* out_left, double* out_right, double* out_mono,
+                         unsigned int frames )
+{
+  const float32x4_t one = vdupq_n_f32(1.0f);
+  const float32x4_t half = vdupq_n_f32(0.5f);
+  unsigned int i = 0;
+  for( ; i + 4 <= frames; i += 4 )
+  {
+    float32x4_t l = vld1q_f32(left + i);
+    float32x4_t r = vld1q_f32(right + i);
+    float32x4_t lp = vaddq_f32(l, one);
+    float32x4_t rp = vaddq_f32(r, one);
+    float32x4_t m = vmulq_f32(vaddq_f32(vmulq_f32(lp, lp), vmulq_f32(rp, rp)), half);
+#if defined(__aarch64__)
+    m = vsubq_f32(vsqrtq_f32(m), one);
+
+    vst1q_f64(out_left + i, vcvt_f64_f32(vget_low_f32(l)));
+    vst1q_f64(out_left + i + 2, vcvt_high_f64_f32(l));
+    vst1q_f64(out_right + i, vcvt_f64_f32(vget_low_f32(r)));
+    vst1q_f64(out_right + i + 2, vcvt_high_f64_f32(r));
+    vst1q_f64(out_mono + i, vcvt_f64_f32(vget_low_f32(m)));
+    vst1q_f64(out_mono + i + 2, vcvt_high_f64_f32(m));
+#else
+    // ARMv7 NEON has neither a square root nor double lanes, so refine
+    // the reciprocal square root estimate (sqrt(x) = x / sqrt(x)) and
+    // widen to double on the way out.
+    m = vmaxq_f32(m, vdupq_n_f32(1e-30f));
+    float32x4_t e = vrsqrteq_f32(m);
+    e = vmulq_f32(e, vrsqrtsq_f32(vmulq_f32(m, e), e));
+    e = vmulq_f32(e, vrsqrtsq_f32(vmulq_f32(m, e), e));
+    m = vsubq_f32(vmulq_f32(m, e), one);
+
+    float mono[4];
+    vst1q_f32(mono, m);
+    for( unsigned int j = 0; j < 4; ++j )
+    {
+      out_left[i + j] = left[i + j];
+      out_right[i + j] = right[i + j];
+      out_mono[i + j] = mono[j];
+    }
+#endif
+  }
+  downmixScalar(left + i, right + i, out_left + i, out_right + i, out_mono + i, frames - i);
+}
+#endif
+
+std::vector<ScopeDownmixKernel> scopeDownmixKernels()
+{
+  std::vector<ScopeDownmixKernel> kernels;
+  ScopeDownmixKernel scalar = { "scalar", downmixScalar };
+  kernels.push_back(scalar);
+#ifdef SCOPE_DSP_SSE2
+  ScopeDownmixKernel sse2 = { "sse2", downmixSSE2 };
+  kernels.push_back(sse2);
+#endif
+#ifdef SCOPE_DSP_AVX2
+  if( cpuHasAVX2() )
+  {
+    ScopeDownmixKernel avx2 = { "avx2", downmixAVX2 };
+    kernels.push_back(avx2);
+  }
+#endif
+#ifdef SCOPE_DSP_NEON
+  ScopeDownmixKernel neon = { "neon", downmixNEON };
+  kernels.push_back(neon);
+#endif
+  return kernels;
+}
+
+const ScopeDownmixKernel& scopeDownmixKernel()
+{
+  // kernels are listed slowest first
+  static const ScopeDownmixKernel best = scopeDownmixKernels().back();
+  return best;
+}
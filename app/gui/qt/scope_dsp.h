@@ -0,0 +1,38 @@
+//--
+// This file is part of Sonic Pi: http://sonic-pi.net
+// Full project source: https://github.com/samaaron/sonic-pi
+// License: https://github.com/samaaron/sonic-pi/blob/master/LICENSE.md
+//
+// Copyright 2013, 2014, 2015, 2016 by Sam Aaron (http://sam.aaron.name).
+// All rights reserved.
+//
+// Permission is granted for use, copying, modification, and
+// distribution of modified versions of this work as long as this
+// notice is included.
+//++
+
+#ifndef SCOPE_DSP_H
+#define SCOPE_DSP_H
+
+#include <vector>
+
+// Converts a block of left/right scsynth scope frames to doubles and
+// computes the mono RMS downmix sqrt(((l+1)^2 + (r+1)^2) / 2) - 1.
+typedef void (*scope_downmix_fn)( const float* left, const float* right,
+                                  double* out_left, double* out_right, double* out_mono,
+                                  unsigned int frames );
+
+struct ScopeDownmixKernel
+{
+  const char* name;
+  scope_downmix_fn fn;
+};
+
+// The fastest kernel supported by the CPU we are running on. The
+// choice is made once on first use.
+const ScopeDownmixKernel& scopeDownmixKernel();
+
+// Every kernel usable on this CPU, scalar first. Used by the benchmark.
+std::vector<ScopeDownmixKernel> scopeDownmixKernels();
+
+#endif
@@ -0,0 +1,187 @@
+//--
+// This file is part of Sonic Pi: http://sonic-pi.net
+// Full project source: https://github.com/samaaron/sonic-pi
+// License: https://github.com/samaaron/sonic-pi/blob/master/LICENSE.md
+//
+// Copyright 2013, 2014, 2015, 2016 by Sam Aaron (http://sam.aaron.name).
+// All rights reserved.
+//
+// Permission is granted for use, copying, modification, and
+// distribution of modified versions of this work as long as this
+// notice is included.
+//++
+
+#include "scope_spectrum.h"
+
+#include <algorithm>
+#include <cmath>
+
+static const double SCOPE_PI = 3.14159265358979323846;
+
+ScopeFFT::ScopeFFT( unsigned int size ) : size(size), half(size / 2), bitrev(half), twiddles(half / 2), split(half + 1), work(half)
+{
+  unsigned int bits = 0;
+  while( (1u << bits) < half ) ++bits;
+  for( unsigned int i = 0; i < half; ++i )
+  {
+    unsigned int r = 0;
+    for( unsigned int b = 0; b < bits; ++b )
+    {
+      if( i & (1u << b) ) r |= 1u << (bits - 1 - b);
+    }
+    bitrev[i] = r;
+  }
+  for( unsigned int i = 0; i < half / 2; ++i )
+  {
+    twiddles[i] = std::polar( 1.0f, (float)(-2.0 * SCOPE_PI * i / half) );
+  }
+  for( unsigned int k = 0; k <= half; ++k )
+  {
+    split[k] = std::polar( 1.0f, (float)(-2.0 * SCOPE_PI * k / size) );
+  }
+}
+
+void ScopeFFT::forward( const float* in, std::complex<float>* out )
+{
+  // pack even samples into the real part and odd into the imaginary
+  for( unsigned int i = 0; i < half; ++i )
+  {
+    work[bitrev[i]] = std::complex<float>( in[2 * i], in[2 * i + 1] );
+  }
+
+  for( unsigned int len = 2; len <= half; len <<= 1 )
+  {
+    unsigned int step = half / len;
+    for( unsigned int start = 0; start < half; start += len )
+    {
+      for( unsigned int j = 0; j < len / 2; ++j )
+      {
+        std::complex<float> t = twiddles[j * step] * work[start + j + len / 2];
+        work[start + j + len / 2] = work[start + j] - t;
+        work[start + j] += t;
+      }
+    }
+  }
+
+  // untangle the even and odd halves into the real signal's spectrum
+  for( unsigned int k = 0; k <= half; ++k )
+  {
+    std::complex<float> a = work[k % half];
+    std::complex<float> b = std::conj( work[(half - k) % half] );
+    std::complex<float> even = (a + b) * 0.5f;
+    std::complex<float> odd = (a - b) * std::complex<float>( 0.0f, -0.5f );
+    out[k] = even + split[k] * odd;
+  }
+}
+
+const unsigned int ScopeSpectrum::Size;
+const unsigned int ScopeSpectrum::Bins;
+
+ScopeSpectrum::ScopeSpectrum() :
+  inputWrite(0), inputRead(0),
+  fft(Size), history(Size, 0.0f), window(Size), frame(Size), bins(Bins), historyPos(0),
+  front(0), back(1), middle(2), running(true)
+{
+  // Hann window, normalised so a full scale sine reads 0 dB
+  float sum = 0;
+  for( unsigned int i = 0; i < Size; ++i )
+  {
+    window[i] = 0.5f - 0.5f * (float)std::cos( 2.0 * SCOPE_PI * i / (Size - 1) );
+    sum += window[i];
+  }
+  for( unsigned int i = 0; i < Size; ++i )
+  {
+    window[i] *= 2.0f / sum;
+  }
+  for( int s = 0; s < 3; ++s )
+  {
+    std::fill_n( spectra[s], Bins, -120.0f );
+  }
+
+  worker = std::thread( &ScopeSpectrum::run, this );
+}
+
+ScopeSpectrum::~ScopeSpectrum()
+{
+  {
+    std::lock_guard<std::mutex> lock( wakeMutex );
+    running = false;
+  }
+  wake.notify_one();
+  worker.join();
+}
+
+void ScopeSpectrum::push( const float* left, const float* right, unsigned int frames )
+{
+  unsigned int w = inputWrite.load( std::memory_order_relaxed );
+  unsigned int r = inputRead.load( std::memory_order_acquire );
+  unsigned int space = InputSize - (w - r);
+
+  // if the worker has fallen behind keep the newest frames that fit
+  if( frames > space )
+  {
+    left += frames - space;
+    right += frames - space;
+    frames = space;
+  }
+  if( frames == 0 ) return;
+
+  for( unsigned int i = 0; i < frames; ++i )
+  {
+    input[(w + i) % InputSize] = (left[i] + right[i]) * 0.5f;
+  }
+  inputWrite.store( w + frames, std::memory_order_release );
+
+  // the worker only holds this while checking for input, never while
+  // analysing, so it is uncontended in practice
+  std::lock_guard<std::mutex> lock( wakeMutex );
+  wake.notify_one();
+}
+
+bool ScopeSpectrum::poll()
+{
+  if( !(middle.load( std::memory_order_relaxed ) & Dirty) ) return false;
+  front = middle.exchange( front, std::memory_order_acq_rel ) & ~Dirty;
+  return true;
+}
+
+void ScopeSpectrum::run()
+{
+  for( ;; )
+  {
+    {
+      std::unique_lock<std::mutex> lock( wakeMutex );
+      wake.wait( lock, [this] {
+          return !running || inputWrite.load( std::memory_order_acquire ) != inputRead.load( std::memory_order_relaxed );
+        } );
+      if( !running ) return;
+    }
+    analyse();
+  }
+}
+
+void ScopeSpectrum::analyse()
+{
+  unsigned int r = inputRead.load( std::memory_order_relaxed );
+  unsigned int w = inputWrite.load( std::memory_order_acquire );
+  for( ; r != w; ++r )
+  {
+    history[historyPos] = input[r % InputSize];
+    historyPos = (historyPos + 1) % Size;
+  }
+  inputRead.store( r, std::memory_order_release );
+
+  for( unsigned int i = 0; i < Size; ++i )
+  {
+    frame[i] = history[(historyPos + i) % Size] * window[i];
+  }
+  fft.forward( frame.data(), bins.data() );
+
+  float* out = spectra[back];
+  for( unsigned int k = 0; k < Bins; ++k )
+  {
+    float mag = std::abs( bins[k] );
+    out[k] = 20.0f * std::log10( std::max( mag, 1e-6f ) );
+  }
+  back = middle.exchange( back | Dirty, std::memory_order_acq_rel ) & ~Dirty;
+}
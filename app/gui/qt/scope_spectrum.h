@@ -0,0 +1,88 @@
+//--
+// This file is part of Sonic Pi: http://sonic-pi.net
+// Full project source: https://github.com/samaaron/sonic-pi
+// License: https://github.com/samaaron/sonic-pi/blob/master/LICENSE.md
+//
+// Copyright 2013, 2014, 2015, 2016 by Sam Aaron (http://sam.aaron.name).
+// All rights reserved.
+//
+// Permission is granted for use, copying, modification, and
+// distribution of modified versions of this work as long as this
+// notice is included.
+//++
+
+#ifndef SCOPE_SPECTRUM_H
+#define SCOPE_SPECTRUM_H
+
+#include <atomic>
+#include <complex>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Real to complex FFT of a fixed power of two length, computed as a
+// half length complex FFT plus a split step.
+class ScopeFFT
+{
+public:
+  explicit ScopeFFT( unsigned int size );
+
+  // in: size real samples, out: size / 2 + 1 bins
+  void forward( const float* in, std::complex<float>* out );
+
+private:
+  unsigned int size, half;
+  std::vector<unsigned int> bitrev;
+  std::vector<std::complex<float>> twiddles, split, work;
+};
+
+// Spectrum analyser for the scope. The GUI thread pushes new frames
+// (never blocking on the worker) and the worker thread windows the
+// newest Size samples, runs the FFT and publishes magnitudes in dB
+// through a lock-free triple buffer which the GUI thread picks up with
+// poll().
+class ScopeSpectrum
+{
+public:
+  static const unsigned int Size = 2048;
+  static const unsigned int Bins = Size / 2 + 1;
+
+  ScopeSpectrum();
+  ~ScopeSpectrum();
+
+  // GUI thread
+  void push( const float* left, const float* right, unsigned int frames );
+  bool poll();
+  const float* magnitudes() const { return spectra[front]; }
+
+private:
+  void run();
+  void analyse();
+
+  // single producer / single consumer queue of mono input samples
+  static const unsigned int InputSize = 4 * Size;
+  float input[InputSize];
+  std::atomic<unsigned int> inputWrite, inputRead;
+
+  // worker owned analysis state
+  ScopeFFT fft;
+  std::vector<float> history, window, frame;
+  std::vector<std::complex<float>> bins;
+  unsigned int historyPos;
+
+  // triple buffer: the worker writes `back`, the GUI reads `front` and
+  // they swap through `middle`, whose dirty bit says it holds a newer
+  // spectrum than `front`
+  static const int Dirty = 4;
+  float spectra[3][Bins];
+  int front, back;
+  std::atomic<int> middle;
+
+  std::mutex wakeMutex;
+  std::condition_variable wake;
+  bool running;
+  std::thread worker;
+};
+
+#endif
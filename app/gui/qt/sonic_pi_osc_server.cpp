@@ -27,6 +27,10 @@ bool SonicPiOSCServer::waitForServer(){
   return !handler->server_started && continueListening();
 }
 
+bool SonicPiOSCServer::waitForBoot(){
+  return !handler->server_booted && continueListening();
+}
+
 bool SonicPiOSCServer::continueListening(){
   return !handler->signal_server_stop && !stop_server;
 }
@@ -39,5 +43,9 @@ bool SonicPiOSCServer::isServerStarted(){
   return handler->server_started;
 }
 
+bool SonicPiOSCServer::isServerBooted(){
+  return handler->server_booted;
+}
+
 void SonicPiOSCServer::stop(){}
 void SonicPiOSCServer::start(){}
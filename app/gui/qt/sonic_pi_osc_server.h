@@ -23,8 +23,10 @@ class SonicPiOSCServer : public QObject
 public:
     explicit SonicPiOSCServer(MainWindow *parent = 0, OscHandler *handler = 0, int port_num = 4558);
     bool waitForServer();
+    bool waitForBoot();
     bool isIncomingPortOpen();
     bool isServerStarted();
+    bool isServerBooted();
 
 
 signals:
@@ -34,6 +34,7 @@ void SonicPiTCPOSCServer::start(){
 
 void SonicPiTCPOSCServer::stop(){
     tcpServer->close();
+    handler->printMessageCounts(std::cout);
 }
 
 void SonicPiTCPOSCServer::logError(QAbstractSocket::SocketError e){
@@ -48,7 +49,7 @@ void SonicPiTCPOSCServer::client(){
     connect(socket, SIGNAL(readyRead()), this, SLOT(readMessage()));
     connect(socket, SIGNAL(error(QAbstractSocket::SocketError)), this, SLOT(logError(QAbstractSocket::SocketError)));
     connect(socket, SIGNAL(disconnected()), socket, SLOT(deleteLater()));
-    std::vector<char>().swap(buffer);
+    buffer.clear();
 }
 
 void SonicPiTCPOSCServer::readMessage()
@@ -75,10 +76,7 @@ void SonicPiTCPOSCServer::readMessage()
             blockSize = 0;
             return;
         }
-        std::vector<char> tmp(buffer);
-        tmp.swap(buffer);
-        handler->oscMessage(buffer);
+        handler->oscMessage(&buffer[0], buffer.size());
         blockSize = 0;
-        std::vector<char>().swap(buffer);
     }
 }
@@ -45,11 +45,12 @@ void SonicPiUDPOSCServer::start(){
 
   while (sock.isOk() && continueListening()) {
     if (sock.receiveNextPacket(30 /* timeout, in ms */)) {
-      handler->oscMessage(sock.buffer);
-      std::vector<char>().swap(sock.buffer);
+      handler->oscMessage((const char *)sock.packetData(), sock.packetSize());
       std::cout << std::flush;
     }
   }
 
-  std::cout << "[GUI] - UDP OSC Server no longer listening" << std::endl << std::flush;
+  std::cout << "[GUI] - UDP OSC Server no longer listening" << std::endl;
+  handler->printMessageCounts(std::cout);
+  std::cout << std::flush;
 }
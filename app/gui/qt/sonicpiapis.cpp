@@ -12,8 +12,10 @@
 //++
 
 
-#include <QDir>
 #include <iostream>
+#include <algorithm>
+#include <iterator>
+#include <QSet>
 
 #include "sonicpiapis.h"
 
@@ -40,28 +42,52 @@ SonicPiAPIs::SonicPiAPIs(QsciLexer *lexer)
   keywords[Tuning] << ":just" << ":pythagorean" << ":meantone" << ":equal";
 
   keywords[MidiParam] << "sustain:" << "velocity:" << "vel:" << "velocity_f:" << "vel_f:" << "port:" << "channel:";
-}
 
+  for (int ctx = 0; ctx < NContext; ctx++) {
+    sortKeywords(ctx);
+  }
+}
 
+// Each context's keywords are kept sorted and free of duplicates so
+// that completions are a binary search for the first match followed by
+// a scan over just the matches.
+void SonicPiAPIs::sortKeywords(int context) {
+  keywords[context].sort();
+  keywords[context].removeDuplicates();
+}
 
-void SonicPiAPIs::loadSamples(QString sample_path) {
-  QDir dir(sample_path);
-  QStringList filetypes;
-  filetypes << "*.wav" << "*.wave" << "*.aif" << "*.aiff" << "*.flac";
-  dir.setNameFilters(filetypes);
 
-  QFileInfoList files = dir.entryInfoList(QDir::Files | QDir::NoDotAndDotDot);
-  foreach (QFileInfo file, files) {
-    addSymbol(Sample, file.baseName());
-  }
-}
 
 void SonicPiAPIs::addSymbol(int context, QString sym) {
   addKeyword(context, QString(":" + sym));
 }
 
 void SonicPiAPIs::addKeyword(int context, QString keyword) {
-  keywords[context] << keyword;
+  QStringList &words = keywords[context];
+  QStringList::iterator it = std::lower_bound(words.begin(), words.end(), keyword);
+  if (it == words.end() || *it != keyword) {
+    words.insert(it, keyword);
+  }
+}
+
+// Merges in a batch of keywords, such as the samples found in a
+// directory, in one pass rather than an insert per keyword.
+void SonicPiAPIs::addKeywords(int context, QStringList batch) {
+  batch.sort();
+  QStringList &words = keywords[context];
+  QStringList merged;
+  merged.reserve(words.size() + batch.size());
+  std::merge(words.constBegin(), words.constEnd(), batch.constBegin(), batch.constEnd(), std::back_inserter(merged));
+  merged.erase(std::unique(merged.begin(), merged.end()), merged.end());
+  words.swap(merged);
+}
+
+void SonicPiAPIs::removeKeywords(int context, const QStringList &batch) {
+  QSet<QString> remove = batch.toSet();
+  QStringList &words = keywords[context];
+  words.erase(std::remove_if(words.begin(), words.end(),
+                             [&remove](const QString &w) { return remove.contains(w); }),
+              words.end());
 }
 
 void SonicPiAPIs::addFXArgs(QString fx, QStringList args) {
@@ -73,7 +99,7 @@ void SonicPiAPIs::addSynthArgs(QString fx, QStringList args) {
 }
 
 void SonicPiAPIs::addCuePath(QString path) {
-  keywords[CuePath] << path;
+  addKeyword(CuePath, path);
 }
 
 void SonicPiAPIs::updateAutoCompletionList(const QStringList &context,
@@ -173,10 +199,10 @@ void SonicPiAPIs::updateAutoCompletionList(const QStringList &context,
   if (partial == "") {
     list << keywords[ctx];
   } else {
-    foreach (const QString &str, keywords[ctx]) {
-      if (str.startsWith(partial)) {
-	list << str;
-      }
+    const QStringList &words = keywords[ctx];
+    QStringList::const_iterator it = std::lower_bound(words.constBegin(), words.constEnd(), partial);
+    for (; it != words.constEnd() && it->startsWith(partial); ++it) {
+      list << *it;
     }
   }
 }
@@ -23,10 +23,11 @@ class SonicPiAPIs : public QsciAbstractAPIs
 
   void addSymbol(int context, QString sym);
   void addKeyword(int context, QString keyword);
+  void addKeywords(int context, QStringList batch);
+  void removeKeywords(int context, const QStringList &batch);
   void addFXArgs(QString fx, QStringList args);
   void addSynthArgs(QString fx, QStringList args);
   void addCuePath(QString path);
-  void loadSamples(QString sample_path);
 
 
   //! \reimp
@@ -39,6 +40,8 @@ class SonicPiAPIs : public QsciAbstractAPIs
 
 
  private:
+  void sortKeywords(int context);
+
   QStringList keywords[NContext];
   QHash<QString, QStringList> fxArgs;
   QHash<QString, QStringList> synthArgs;
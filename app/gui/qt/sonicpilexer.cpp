@@ -17,14 +17,108 @@
 
 
 
+namespace {
+  struct StyleKey {
+    int style;
+    const char *key;
+  };
+}
+
+static const StyleKey foregroundKeys[] = {
+  { QsciLexerRuby::Default, "DefaultForeground" },
+  { QsciLexerRuby::Comment, "CommentForeground" },
+  { QsciLexerRuby::POD, "PODForeground" },
+  { QsciLexerRuby::Number, "NumberForeground" },
+  { QsciLexerRuby::FunctionMethodName, "FunctionMethodNameForeground" },
+  { QsciLexerRuby::Keyword, "KeywordForeground" },
+  { QsciLexerRuby::DemotedKeyword, "DemotedKeywordForeground" },
+  { QsciLexerRuby::DoubleQuotedString, "DoubleQuotedStringForeground" },
+  { QsciLexerRuby::SingleQuotedString, "SingleQuotedStringForeground" },
+  { QsciLexerRuby::HereDocument, "HereDocumentForeground" },
+  { QsciLexerRuby::PercentStringq, "PercentStringqForeground" },
+  { QsciLexerRuby::PercentStringQ, "PercentStringQForeground" },
+  { QsciLexerRuby::ClassName, "ClassNameForeground" },
+  { QsciLexerRuby::Regex, "RegexForeground" },
+  { QsciLexerRuby::HereDocumentDelimiter, "HereDocumentDelimiterForeground" },
+  { QsciLexerRuby::PercentStringr, "PercentStringrForeground" },
+  { QsciLexerRuby::PercentStringw, "PercentStringwForeground" },
+  { QsciLexerRuby::Global, "GlobalForeground" },
+  { QsciLexerRuby::Symbol, "SymbolForeground" },
+  { QsciLexerRuby::ModuleName, "ModuleNameForeground" },
+  { QsciLexerRuby::InstanceVariable, "InstanceVariableForeground" },
+  { QsciLexerRuby::ClassVariable, "ClassVariableForeground" },
+  { QsciLexerRuby::Backticks, "BackticksForeground" },
+  { QsciLexerRuby::PercentStringx, "PercentStringxForeground" },
+  { QsciLexerRuby::DataSection, "DataSectionForeground" }
+};
+
+static const StyleKey backgroundKeys[] = {
+  { QsciLexerRuby::Default, "DefaultBackground" },
+  { QsciLexerRuby::Comment, "CommentBackground" },
+  { QsciLexerRuby::Error, "ErrorBackground" },
+  { QsciLexerRuby::POD, "PODBackground" },
+  { QsciLexerRuby::Regex, "RegexBackground" },
+  { QsciLexerRuby::PercentStringr, "PercentStringrBackground" },
+  { QsciLexerRuby::Backticks, "BackticksBackground" },
+  { QsciLexerRuby::PercentStringx, "PercentStringxBackground" },
+  { QsciLexerRuby::DataSection, "DataSectionBackground" },
+  { QsciLexerRuby::HereDocumentDelimiter, "DocumentDelimiterBackground" },
+  { QsciLexerRuby::HereDocument, "HereDocumentBackground" },
+  { QsciLexerRuby::PercentStringw, "PercentStringwBackground" },
+  { QsciLexerRuby::Stdin, "StdinBackground" },
+  { QsciLexerRuby::Stdout, "StdoutBackground" },
+  { QsciLexerRuby::Stderr, "StderrBackground" },
+  { QsciLexerRuby::FunctionMethodName, "FunctionMethodNameBackground" },
+  { QsciLexerRuby::Number, "NumberBackground" },
+  { QsciLexerRuby::Keyword, "KeywordBackground" },
+  { QsciLexerRuby::DemotedKeyword, "DemotedKeywordBackground" },
+  { QsciLexerRuby::DoubleQuotedString, "DoubleQuotedStringBackground" },
+  { QsciLexerRuby::SingleQuotedString, "SingleQuotedStringBackground" },
+  { QsciLexerRuby::PercentStringq, "PercentStringqBackground" },
+  { QsciLexerRuby::PercentStringQ, "PercentStringQBackground" },
+  { QsciLexerRuby::ClassName, "ClassNameBackground" },
+  { QsciLexerRuby::Global, "GlobalBackground" },
+  { QsciLexerRuby::Symbol, "SymbolBackground" },
+  { QsciLexerRuby::ModuleName, "ModuleNameBackground" },
+  { QsciLexerRuby::InstanceVariable, "InstanceVariableBackground" },
+  { QsciLexerRuby::ClassVariable, "ClassVariableBackground" }
+};
+
+static const int numForegroundKeys = sizeof(foregroundKeys) / sizeof(foregroundKeys[0]);
+static const int numBackgroundKeys = sizeof(backgroundKeys) / sizeof(backgroundKeys[0]);
+
 SonicPiLexer::SonicPiLexer(SonicPiTheme *theme) : QsciLexerRuby() {
     this->theme = theme;
-    this->setDefaultColor(theme->color("Foreground"));
-    this->setDefaultPaper(theme->color("Background"));
+    updateColors();
+    connect(theme, SIGNAL(themeChanged()), this, SLOT(updateColors()));
+    this->setDefaultColor(foreground);
+    this->setDefaultPaper(background);
 }
 
 static char default_font[] = "Hack";
 
+void SonicPiLexer::updateColors()
+{
+    for (int i = 0; i < NumStyles; i++) {
+      themedColor[i] = false;
+      themedPaper[i] = false;
+    }
+    for (int i = 0; i < numForegroundKeys; i++) {
+      const StyleKey &k = foregroundKeys[i];
+      Q_ASSERT(k.style < NumStyles);
+      colors[k.style] = theme->color(k.key);
+      themedColor[k.style] = true;
+    }
+    for (int i = 0; i < numBackgroundKeys; i++) {
+      const StyleKey &k = backgroundKeys[i];
+      Q_ASSERT(k.style < NumStyles);
+      papers[k.style] = theme->color(k.key);
+      themedPaper[k.style] = true;
+    }
+    foreground = theme->color("Foreground");
+    background = theme->color("Background");
+}
+
 // triggers autocompletion for the next word
 QStringList SonicPiLexer::autoCompletionWordSeparators() const {
   QStringList seps;
@@ -34,167 +128,38 @@ QStringList SonicPiLexer::autoCompletionWordSeparators() const {
 
 void SonicPiLexer::highlightAll()
 {
-    setPaper(QColor("deeppink"),-1);
-    setColor(QColor("white"), -1);
-    this->setDefaultPaper(theme->color("Background"));
+    static const QColor highlightPaper("deeppink");
+    static const QColor highlightColor("white");
+    setPaper(highlightPaper, -1);
+    setColor(highlightColor, -1);
+    this->setDefaultPaper(background);
 }
 
 void SonicPiLexer::unhighlightAll()
 {
-    setPaper(theme->color("Background"));
-    setColor(theme->color("Foreground"));
-
-    setColor(theme->color("DefaultForeground"), Default);
-    setColor(theme->color("CommentForeground"),Comment);
-    setColor(theme->color("PODForeground"),POD);
-    setColor(theme->color("NumberForeground"),Number);
-    setColor(theme->color("FunctionMethodNameForeground"),FunctionMethodName);
-    setColor(theme->color("KeywordForeground"),Keyword);
-    setColor(theme->color("DemotedKeywordForeground"),DemotedKeyword);
-    setColor(theme->color("DoubleQuotedStringForeground"),DoubleQuotedString);
-    setColor(theme->color("SingleQuotedStringForeground"),SingleQuotedString);
-    setColor(theme->color("HereDocumentForeground"),HereDocument);
-    setColor(theme->color("PercentStringqForeground"),PercentStringq);
-    setColor(theme->color("PercentStringQForeground"),PercentStringQ);
-    setColor(theme->color("ClassNameForeground"),ClassName);
-    setColor(theme->color("RegexForeground"),Regex);
-    setColor(theme->color("HereDocumentDelimiterForeground"),HereDocumentDelimiter);
-    setColor(theme->color("PercentStringrForeground"),PercentStringr);
-    setColor(theme->color("PercentStringwForeground"),PercentStringw);
-    setColor(theme->color("GlobalForeground"),Global);
-    setColor(theme->color("SymbolForeground"),Symbol);
-    setColor(theme->color("ModuleNameForeground"),ModuleName);
-    setColor(theme->color("InstanceVariableForeground"),InstanceVariable);
-    setColor(theme->color("ClassVariableForeground"),ClassVariable);
-    setColor(theme->color("BackticksForeground"),Backticks);
-    setColor(theme->color("PercentStringxForeground"),PercentStringx);
-    setColor(theme->color("DataSectionForeground"),DataSection);
+    setPaper(background);
+    setColor(foreground);
+
+    for (int i = 0; i < numForegroundKeys; i++) {
+      setColor(colors[foregroundKeys[i].style], foregroundKeys[i].style);
+    }
 }
 
 QColor SonicPiLexer::defaultColor(int style) const
 {
-    switch (style)
-    {
-    case Default:
-      return theme->color("DefaultForeground");
-    case Comment:
-      return theme->color("CommentForeground");
-    case POD:
-      return theme->color("PODForeground");
-    case Number:
-      return theme->color("NumberForeground");
-    case FunctionMethodName:
-      return theme->color("FunctionMethodNameForeground");
-    case Keyword:
-      return theme->color("KeywordForeground");
-    case DemotedKeyword:
-      return theme->color("DemotedKeywordForeground");
-    case DoubleQuotedString:
-      return theme->color("DoubleQuotedStringForeground");
-    case SingleQuotedString:
-      return theme->color("SingleQuotedStringForeground");
-    case HereDocument:
-      return theme->color("HereDocumentForeground");
-    case PercentStringq:
-      return theme->color("PercentStringqForeground");
-    case PercentStringQ:
-      return theme->color("PercentStringQForeground");
-    case ClassName:
-      return theme->color("ClassNameForeground");
-    case Regex:
-      return theme->color("RegexForeground");
-    case HereDocumentDelimiter:
-      return theme->color("HereDocumentDelimiterForeground");
-    case PercentStringr:
-      return theme->color("PercentStringrForeground");
-    case PercentStringw:
-      return theme->color("PercentStringwForeground");
-    case Global:
-      return theme->color("GlobalForeground");
-    case Symbol:
-      return theme->color("SymbolForeground");
-    case ModuleName:
-      return theme->color("ModuleNameForeground");
-    case InstanceVariable:
-      return theme->color("InstanceVariableForeground");
-    case ClassVariable:
-      return theme->color("ClassVariableForeground");
-    case Backticks:
-      return theme->color("BackticksForeground");
-    case PercentStringx:
-      return theme->color("PercentStringxForeground");
-    case DataSection:
-      return theme->color("DataSectionForeground");
+    if (style >= 0 && style < NumStyles && themedColor[style]) {
+      return colors[style];
     }
-
     return QsciLexer::defaultColor(style);
 }
 
 // Returns the background colour of the text for a style.
 QColor SonicPiLexer::defaultPaper(int style) const
 {
-  switch (style)
-  {
-    case Default:
-      return theme->color("DefaultBackground");
-    case Comment:
-       return theme->color("CommentBackground");
-    case Error:
-      return theme->color("ErrorBackground");
-    case POD:
-      return theme->color("PODBackground");
-    case Regex:
-      return theme->color("RegexBackground");
-    case PercentStringr:
-      return theme->color("PercentStringrBackground");
-    case Backticks:
-      return theme->color("BackticksBackground");
-    case PercentStringx:
-      return theme->color("PercentStringxBackground");
-    case DataSection:
-      return theme->color("DataSectionBackground");
-    case HereDocumentDelimiter:
-      return theme->color("DocumentDelimiterBackground");
-    case HereDocument:
-      return theme->color("HereDocumentBackground");
-    case PercentStringw:
-      return theme->color("PercentStringwBackground");
-    case Stdin:
-      return theme->color("StdinBackground");
-    case Stdout:
-      return theme->color("StdoutBackground");
-    case Stderr:
-      return theme->color("StderrBackground");
-    case FunctionMethodName:
-      return theme->color("FunctionMethodNameBackground");
-    case Number:
-     return theme->color("NumberBackground");
-    case Keyword:
-      return theme->color("KeywordBackground");
-    case DemotedKeyword:
-      return theme->color("DemotedKeywordBackground");
-    case DoubleQuotedString:
-      return theme->color("DoubleQuotedStringBackground");
-    case SingleQuotedString:
-      return theme->color("SingleQuotedStringBackground");
-    case PercentStringq:
-      return theme->color("PercentStringqBackground");
-    case PercentStringQ:
-      return theme->color("PercentStringQBackground");
-    case ClassName:
-      return theme->color("ClassNameBackground");
-    case Global:
-      return theme->color("GlobalBackground");
-    case Symbol:
-      return theme->color("SymbolBackground");
-    case ModuleName:
-      return theme->color("ModuleNameBackground");
-    case InstanceVariable:
-      return theme->color("InstanceVariableBackground");
-    case ClassVariable:
-      return theme->color("ClassVariableBackground");
-  }
-  return QsciLexer::defaultPaper(style);
+    if (style >= 0 && style < NumStyles && themedPaper[style]) {
+      return papers[style];
+    }
+    return QsciLexer::defaultPaper(style);
 }
 
 
@@ -17,6 +17,8 @@
 
 class SonicPiLexer : public QsciLexerRuby
 {
+  Q_OBJECT
+
 public:
   SonicPiLexer(SonicPiTheme *customTheme);
   QColor defaultColor(int style) const;
@@ -27,4 +29,15 @@ public:
   void unhighlightAll();
   SonicPiTheme *theme;
 
+public slots:
+  // re-resolves the per style colours from the theme
+  void updateColors();
+
+private:
+  // Scintilla asks for these per style on every restyle, so they are
+  // looked up once per theme rather than parsed from the theme's strings
+  static const int NumStyles = 64;
+  QColor colors[NumStyles], papers[NumStyles];
+  bool themedColor[NumStyles], themedPaper[NumStyles];
+  QColor foreground, background;
 };
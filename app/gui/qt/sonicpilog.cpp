@@ -16,12 +16,29 @@
 
 // Standard stuff
 #include <vector>
+#include <iostream>
 #include "sonicpitheme.h"
+#include <QFile>
 #include <QScrollBar>
+#include <QTextCursor>
+#include <QTimer>
+
+// one frame at 60Hz
+static const int LOG_FLUSH_INTERVAL = 16;
 
 SonicPiLog::SonicPiLog(QWidget *parent) : QPlainTextEdit(parent)
 {
   forceScroll = true;
+  flushPending = false;
+  maxLines = 1000;
+  spillFile = 0;
+  // the log is read only, so there is nothing to undo
+  setUndoRedoEnabled(false);
+
+  flushTimer = new QTimer(this);
+  flushTimer->setSingleShot(true);
+  flushTimer->setInterval(LOG_FLUSH_INTERVAL);
+  connect(flushTimer, SIGNAL(timeout()), this, SLOT(flush()));
 }
 
 void SonicPiLog::forceScrollDown(bool force)
@@ -58,9 +75,55 @@ void SonicPiLog::setFontFamily(QString font_name)
   setFont(QFont(font_name));
 }
 
+void SonicPiLog::setMaxLines(int max_lines)
+{
+  maxLines = max_lines;
+  QTextCursor cursor(document());
+  trim(cursor);
+}
+
+void SonicPiLog::setSpillPath(const QString &path)
+{
+  delete spillFile;
+  spillFile = 0;
+  if(path.isEmpty()) {
+    return;
+  }
+
+  spillFile = new QFile(path, this);
+  if(!spillFile->open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text)) {
+    std::cout << "[GUI] - unable to open log spill file " << path.toStdString() << std::endl;
+    delete spillFile;
+    spillFile = 0;
+  }
+}
+
+void SonicPiLog::trim(QTextCursor &cursor)
+{
+  if(maxLines <= 0) {
+    return;
+  }
+  int excess = document()->blockCount() - maxLines;
+  if(excess <= maxLines / 4) {
+    return;
+  }
+
+  // removing lines from the top is the expensive part of a bounded
+  // log, so do it rarely and many lines at a time
+  cursor.movePosition(QTextCursor::Start);
+  cursor.movePosition(QTextCursor::NextBlock, QTextCursor::KeepAnchor, excess);
+  if(spillFile) {
+    spillFile->write(cursor.selection().toPlainText().toUtf8());
+    spillFile->flush();
+  }
+  cursor.removeSelectedText();
+}
+
 void SonicPiLog::appendPlainText(QString text)
 {
   QPlainTextEdit::appendPlainText(text);
+  QTextCursor cursor(document());
+  trim(cursor);
   if(forceScroll) {
     QScrollBar *sb = verticalScrollBar();
     sb->setValue(sb->maximum());
@@ -68,17 +131,74 @@ void SonicPiLog::appendPlainText(QString text)
 }
 
 
-void SonicPiLog::handleMultiMessage(SonicPiLog::MultiMessage mm)
+void SonicPiLog::post(const Runs &runs)
 {
+  QMutexLocker lock(&queueMutex);
+  queue.insert(queue.end(), runs.begin(), runs.end());
+  if(!flushPending) {
+    flushPending = true;
+    QMetaObject::invokeMethod(this, "scheduleFlush", Qt::QueuedConnection);
+  }
+}
+
+void SonicPiLog::scheduleFlush()
+{
+  if(!flushTimer->isActive()) {
+    flushTimer->start();
+  }
+}
+
+void SonicPiLog::flush()
+{
+  Runs runs;
+  {
+    QMutexLocker lock(&queueMutex);
+    runs.swap(queue);
+    flushPending = false;
+  }
+  if(runs.empty()) {
+    return;
+  }
+
+  // a single edit block means one layout and repaint for everything
+  // that arrived during the last frame
+  QTextCursor cursor(document());
+  cursor.beginEditBlock();
+  cursor.movePosition(QTextCursor::End);
+  for(size_t i = 0 ; i < runs.size() ; i++) {
+    const Run &run = runs[i];
+    if(run.new_line && !document()->isEmpty()) {
+      cursor.insertBlock();
+    }
+    cursor.insertText(run.text, run.format);
+  }
+  trim(cursor);
+  cursor.endEditBlock();
+
+  if(forceScroll) {
+    QScrollBar *sb = verticalScrollBar();
+    sb->setValue(sb->maximum());
+  }
+}
+
+void SonicPiLog::postMultiMessage(const SonicPiLog::MultiMessage &mm)
+{
+    static const QColor msg_deeppink("deeppink");
+    static const QColor msg_dodgerblue("dodgerblue");
+    static const QColor msg_darkorange("darkorange");
+    static const QColor msg_red("red");
+    static const QColor msg_white("white");
+    static const QColor msg_green("green");
+
     int msg_count = mm.messages.size();
     SonicPiTheme *theme = mm.theme;
 
+    Runs runs;
     QTextCharFormat tf;
     QString ss;
 
-    tf.setForeground(theme->color("LogDefaultForeground"));
-    tf.setBackground(theme->color("LogBackground"));
-    setCurrentCharFormat(tf);
+    tf.setForeground(theme->logColor(SonicPiTheme::LogDefaultForeground));
+    tf.setBackground(theme->logColor(SonicPiTheme::LogBackground));
 
     ss.append("{run: ").append(QString::number(mm.job_id));
     ss.append(", time: ").append(QString::fromStdString(mm.runtime));
@@ -86,12 +206,12 @@ void SonicPiLog::handleMultiMessage(SonicPiLog::MultiMessage mm)
       ss.append(", thread: \"").append(QString::fromStdString(mm.thread_name)).append("\"");
     }
     ss.append("}");
-    appendPlainText(ss);
+    runs.push_back(Run(ss, tf, true));
 
     for(int i = 0 ; i < msg_count ; i++) {
       ss = "";
       int msg_type = mm.messages[i].msg_type;
-      std::string s = mm.messages[i].s;
+      const std::string &s = mm.messages[i].s;
 
       QStringList lines = QString::fromUtf8(s.c_str()).split(QRegExp("\\n"));
 
@@ -104,61 +224,55 @@ void SonicPiLog::handleMultiMessage(SonicPiLog::MultiMessage mm)
         ss.append(QString::fromUtf8(" ├─ "));
       }
 
-      appendPlainText(ss);
+      runs.push_back(Run(ss, tf, true));
 
       for (int j = 0; j < lines.size(); ++j) {
         switch(msg_type)
           {
           case 0:
-            tf.setForeground(QColor("deeppink"));
+            tf.setForeground(msg_deeppink);
             break;
           case 1:
-            tf.setForeground(QColor("dodgerblue"));
+            tf.setForeground(msg_dodgerblue);
             break;
           case 2:
-            tf.setForeground(QColor("darkorange"));
+            tf.setForeground(msg_darkorange);
             break;
           case 3:
-            tf.setForeground(QColor("red"));
+            tf.setForeground(msg_red);
             break;
           case 4:
-            tf.setForeground(QColor("white"));
-            tf.setBackground(QColor("deeppink"));
+            tf.setForeground(msg_white);
+            tf.setBackground(msg_deeppink);
             break;
           case 5:
-            tf.setForeground(QColor("white"));
-            tf.setBackground(QColor("dodgerblue"));
+            tf.setForeground(msg_white);
+            tf.setBackground(msg_dodgerblue);
             break;
           case 6:
-            tf.setForeground(QColor("white"));
-            tf.setBackground(QColor("darkorange"));
+            tf.setForeground(msg_white);
+            tf.setBackground(msg_darkorange);
             break;
           default:
-            tf.setForeground(QColor("green"));
+            tf.setForeground(msg_green);
           }
-        setCurrentCharFormat(tf);
-        insertPlainText(lines.at(j));
+        runs.push_back(Run(lines.at(j), tf, false));
         if ((j + 1) < lines.size()) {
-          tf.setForeground(QColor("white"));
-          setCurrentCharFormat(tf);
+          tf.setForeground(msg_white);
           if (i == (msg_count - 1)) {
             // we are the last message
             // so don't print joining lines
-            insertPlainText("\n  ");
+            runs.push_back(Run("\n  ", tf, false));
           } else {
-            insertPlainText("\n │");
+            runs.push_back(Run("\n │", tf, false));
           }
         }
       }
 
-      tf.setForeground(theme->color("LogDefaultForeground"));
-      tf.setBackground(theme->color("LogBackground"));
-      setCurrentCharFormat(tf);
+      tf.setForeground(theme->logColor(SonicPiTheme::LogDefaultForeground));
+      tf.setBackground(theme->logColor(SonicPiTheme::LogBackground));
     }
-    appendPlainText(QString::fromStdString(" "));
+    runs.push_back(Run(" ", tf, true));
 
-    if(forceScroll) {
-      QScrollBar *sb = verticalScrollBar();
-      sb->setValue(sb->maximum());
-    }
+    post(runs);
 }
@@ -15,7 +15,11 @@
 #define SONICPILOG_H
 
 #include <QPlainTextEdit>
+#include <QMutex>
+#include <QTextCharFormat>
 
+class QFile;
+class QTimer;
 class SonicPiTheme;
 
 class SonicPiLog : public QPlainTextEdit
@@ -41,6 +45,29 @@ public:
         Messages messages;
     };
 
+    // A piece of formatted log text. A run that starts a new line is
+    // added like appendPlainText, otherwise like insertPlainText.
+    struct Run
+    {
+        Run(const QString &text, const QTextCharFormat &format, bool new_line) :
+          text(text), format(format), new_line(new_line) {}
+        QString text;
+        QTextCharFormat format;
+        bool new_line;
+    };
+    typedef std::vector<Run> Runs;
+
+    // These may be called from any thread. Posted runs are queued and
+    // drawn together at most once per frame.
+    void post(const Runs &runs);
+    void postMultiMessage(const MultiMessage &mm);
+
+    // Keep roughly the newest max_lines lines. Older lines are evicted
+    // in bulk once the log overshoots by a quarter and, if a spill path
+    // is set, appended to that file.
+    void setMaxLines(int max_lines);
+    void setSpillPath(const QString &path);
+
 signals:
 
 public slots:
@@ -48,13 +75,23 @@ public slots:
     void setTextBackgroundColor(QColor c);
     void setTextBgFgColors(QColor fg, QColor bg);
     void setFontFamily(QString font_name);
-    void handleMultiMessage(SonicPiLog::MultiMessage mm);
     void forceScrollDown(bool force);
     void appendPlainText(QString text);
 
-protected:
-};
+private slots:
+    void scheduleFlush();
+    void flush();
+
+private:
+    void trim(QTextCursor &cursor);
 
-Q_DECLARE_METATYPE(SonicPiLog::MultiMessage)
+    int maxLines;
+    QFile *spillFile;
+
+    QMutex queueMutex;
+    Runs queue;
+    bool flushPending;
+    QTimer *flushTimer;
+};
 
 #endif // SONICPILOG_H
@@ -32,7 +32,22 @@ SonicPiTheme::SonicPiTheme(QObject *parent, QSettings *settings, bool dark) : QO
       }
     }
 
-    this->theme = themeSettings;
+    setTheme(themeSettings);
+}
+
+void SonicPiTheme::setTheme(const QMap<QString, QString> &settings){
+  this->theme = settings;
+
+  static const char *logColorKeys[NumLogColors] = {
+    "LogDefaultForeground",
+    "LogBackground",
+    "LogInfoForeground",
+    "LogInfoBackground",
+    "LogInfoBackgroundStyle1"
+  };
+  for(int i = 0; i < NumLogColors; i++){
+    logColors[i] = color(logColorKeys[i]);
+  }
 }
 
 QMap<QString, QString> SonicPiTheme::withCustomSettings(QMap<QString, QString> settings){
@@ -44,11 +59,13 @@ QMap<QString, QString> SonicPiTheme::withCustomSettings(QMap<QString, QString> s
 }
 
 void SonicPiTheme::darkMode(){
-  this->theme = withCustomSettings(darkTheme());
+  setTheme(withCustomSettings(darkTheme()));
+  emit themeChanged();
 }
 
 void SonicPiTheme::lightMode(){
-  this->theme = withCustomSettings(lightTheme());
+  setTheme(withCustomSettings(lightTheme()));
+  emit themeChanged();
 }
 
 QMap<QString, QString> SonicPiTheme::lightTheme(){
@@ -22,9 +22,20 @@ class SonicPiTheme : public QObject
 {
     Q_OBJECT
 public:
+    // colours used for every line of log output, resolved up front
+    enum LogColor {
+      LogDefaultForeground,
+      LogBackground,
+      LogInfoForeground,
+      LogInfoBackground,
+      LogInfoBackgroundStyle1,
+      NumLogColors
+    };
+
     explicit SonicPiTheme(QObject *parent = 0, QSettings *settings = 0, bool dark = false);
     ~SonicPiTheme();
     QColor color(QString);
+    const QColor &logColor(LogColor c) const { return logColors[c]; }
     QString font(QString);
     void darkMode();
     void lightMode();
@@ -35,8 +46,12 @@ private:
     QMap<QString, QString> darkTheme();
     QMap<QString, QString> theme;
     QMap<QString, QString> customSettings;
+    QColor logColors[NumLogColors];
+    void setTheme(const QMap<QString, QString> &settings);
 
 signals:
+    // emitted after switching between light and dark mode
+    void themeChanged();
 
 public slots:
 };
@@ -129,9 +129,10 @@ struct UdpSocket {
   SockAddr remote_addr; /* initialised for connected sockets. Also updated for bound sockets after each datagram received */
 
   std::vector<char> buffer;
+  size_t packet_size; /* Modified from original: bytes of buffer holding the last datagram */
 
 
-  UdpSocket() : handle(-1) { 
+  UdpSocket() : handle(-1), packet_size(0) { 
 #ifdef WIN32
     WSADATA wsa_data;
     if (WSAStartup(MAKEWORD(2,2), &wsa_data) != 0) {
@@ -220,7 +221,10 @@ struct UdpSocket {
     if (!isOk() || handle == -1) { setErr("not opened.."); return false; }
     /* 128k seems to be a reasonable value -- on linux, the max
        datagram size appears to be a little bit less than 65536 */
-    buffer.resize(1024*128); 
+    /* Modified from original: the buffer is a receive arena that is
+       sized once and reused for every datagram */
+    if (buffer.size() < 1024*128) buffer.resize(1024*128);
+    packet_size = 0;
     
     /* check if something is available */
     if (timeout_ms >= 0) {
@@ -268,16 +272,15 @@ struct UdpSocket {
     }
     if (nread > (int)buffer.size()) {
       /* no luck... a large datagram arrived and we truncated it.. now it is too late */
-      buffer.clear();
+      packet_size = 0;
     } else {
-      buffer.resize(nread);
-      std::vector<char> tmp(buffer); tmp.swap(buffer);
+      packet_size = nread;
     }
     return true;
   }
 
-  void *packetData() { return buffer.empty() ? 0 : &buffer[0]; }
-  size_t packetSize() { return buffer.size(); }
+  void *packetData() { return packet_size == 0 ? 0 : &buffer[0]; }
+  size_t packetSize() { return packet_size; }
   SockAddr &packetOrigin() { return remote_addr; }
   
 
@@ -45,27 +45,29 @@ osc_midi_in = 4562
 
 
 
-case (ARGV[0] || "").downcase
-when "gui-send-to-server"
-  puts gui_send_to_server
-when "gui-listen-to-server"
-  puts gui_listen_to_server
-when "server-send-to-gui"
-  puts server_send_to_gui
-when "server-listen-to-gui"
-  puts server_listen_to_gui
-when "server-osc-cues"
-  puts server_osc_cues
-when "scsynth"
-  puts scsynth
-when "scsynth-send"
-  puts scsynth_send
-when "erlang-router"
-  puts erlang_router
-when "osc-midi-out"
-  puts osc_midi_out
-when "osc-midi-in"
-  puts osc_midi_in
+ports = {
+  "gui-send-to-server"   => gui_send_to_server,
+  "gui-listen-to-server" => gui_listen_to_server,
+  "server-send-to-gui"   => server_send_to_gui,
+  "server-listen-to-gui" => server_listen_to_gui,
+  "server-osc-cues"      => server_osc_cues,
+  "scsynth"              => scsynth,
+  "scsynth-send"         => scsynth_send,
+  "erlang-router"        => erlang_router,
+  "osc-midi-out"         => osc_midi_out,
+  "osc-midi-in"          => osc_midi_in
+}
+
+name = (ARGV[0] || "").downcase
+
+if name == "all"
+  # One "name: port" pair per line so that callers only need to start
+  # Ruby once to discover every port
+  ports.each do |port_name, port|
+    puts "#{port_name}: #{port}"
+  end
+elsif ports.has_key?(name)
+  puts ports[name]
 else
-  puts "Unknown port name: #{ARGV[0]}.\nExpecting one of:\n* gui-send-to-server\n* gui-listen-to-server\n* server-send-to-gui\n* server-listen-to-gui\n* server-osc-cues\n* scsynth\n* scsynth-send"
+  puts "Unknown port name: #{ARGV[0]}.\nExpecting one of:\n* all\n#{ports.keys.map { |k| "* #{k}" }.join("\n")}"
 end
@@ -41,6 +41,7 @@ FileUtils::mkdir "#{qt_gui_path}/book/"
 
 docs = []
 filenames = []
+search_docs = []
 count = 0
 
 options = {}
@@ -62,7 +63,7 @@ make_tab = lambda do |name, doc_items, titleize=false, should_sort=true, with_ke
   docs << "\n"
   docs << "  // #{name} info\n"
 
-  docs << "  struct help_page #{help_pages}[] = {\n"
+  docs << "  static const struct help_page #{help_pages}[] = {\n"
   doc_items = doc_items.sort if should_sort
 
   book = ""
@@ -97,9 +98,7 @@ make_tab = lambda do |name, doc_items, titleize=false, should_sort=true, with_ke
 
     docs << "    { "
 
-    docs << "QString::fromUtf8(" unless title.ascii_only?
     docs << "\"#{title.gsub(/"/, '\\"')}\""
-    docs << ")" unless title.ascii_only?
 
     docs << ", "
 
@@ -119,6 +118,8 @@ make_tab = lambda do |name, doc_items, titleize=false, should_sort=true, with_ke
       f << "#{doc}"
     end
 
+    search_docs << [title.strip, "qrc:///#{filename}", doc.dup]
+
     if chapters then
       c = title[/\A\s*[0-9]+(\.[0-9]+)?/]
       doc.gsub!(/(<h1.*?>)/, "\\1#{c} - ")
@@ -285,6 +286,82 @@ File.open(cpp, 'w') do |f|
   f << new_content.join
 end
 
+###
+# Generate the full text search index
+###
+
+# Inverted index over every help page, read in place by the GUI's
+# HelpSearchIndex. All numbers are little endian 32 bit unsigned ints:
+#
+#   header:   "SPHI", version, doc count, term count,
+#             docs, terms, postings and strings offsets
+#   docs:     title offset, title length, url offset, url length
+#   terms:    term offset, term length, first posting, posting count
+#             (sorted bytewise by term)
+#   postings: doc, weighted term frequency, first position
+#   strings:  UTF-8 text the offsets above point into
+#
+# Words in a page's title count as several occurrences so that pages
+# about a term rank above pages which merely mention it.
+search_index_tokens = lambda do |text|
+  text.downcase.scan(/[\p{L}\p{N}_]+/)
+end
+
+write_search_index = lambda do |path, pages|
+  title_weight = 5
+  postings = Hash.new { |h, k| h[k] = {} }
+  pages.each_with_index do |(title, url, html), doc_id|
+    text = CGI.unescapeHTML(html.gsub(/<[^>]*>/, ' '))
+    search_index_tokens.call(text).each_with_index do |term, pos|
+      entry = (postings[term][doc_id] ||= [0, pos])
+      entry[0] += 1
+    end
+    search_index_tokens.call(title).each do |term|
+      entry = (postings[term][doc_id] ||= [0, 0])
+      entry[0] += title_weight
+    end
+  end
+
+  strings = "".b
+  add_string = lambda do |str|
+    off = strings.bytesize
+    strings << str.b
+    [off, str.bytesize]
+  end
+
+  doc_table = pages.map do |title, url, _|
+    add_string.call(title) + add_string.call(url)
+  end
+
+  term_table = []
+  posting_table = []
+  postings.keys.sort_by(&:b).each do |term|
+    docs_for_term = postings[term]
+    term_table << add_string.call(term) + [posting_table.size, docs_for_term.size]
+    docs_for_term.sort.each do |doc_id, (tf, first)|
+      posting_table << [doc_id, tf, first]
+    end
+  end
+
+  header_size = 4 + 4 * 7
+  docs_off = header_size
+  terms_off = docs_off + doc_table.size * 16
+  postings_off = terms_off + term_table.size * 16
+  strings_off = postings_off + posting_table.size * 12
+
+  File.open(path, 'wb') do |f|
+    f << "SPHI"
+    f << [1, doc_table.size, term_table.size, docs_off, terms_off, postings_off, strings_off].pack("V*")
+    f << doc_table.flatten.pack("V*")
+    f << term_table.flatten.pack("V*")
+    f << posting_table.flatten.pack("V*")
+    f << strings
+  end
+end
+
+write_search_index.call("#{qt_gui_path}/help/search.idx", search_docs)
+filenames << "help/search.idx"
+
 File.open("#{qt_gui_path}/help_files.qrc", 'w') do |f|
   f << "<RCC>\n  <qresource prefix=\"/\">\n"
   f << filenames.map{|n| "    <file>#{n}</file>\n"}.join
@@ -14,6 +14,7 @@
 
 require 'cgi'
 require 'rbconfig'
+require 'zlib'
 
 
 require_relative "../core.rb"
@@ -173,6 +174,107 @@ klass.send(:define_method, :inspect) { "Runtime" }
 
 ws_out = Queue.new
 
+# Send stuff out from Sonic Pi back out to osc_server. This is started
+# before the runtime so that boot phases reach the GUI as they happen.
+out_t = Thread.new do
+  continue = true
+  while continue
+    begin
+      message = ws_out.pop
+      # message[:ts] = Time.now.strftime("%H:%M:%S")
+
+      if message[:type] == :exit
+        begin
+          gui.send("/exited")
+        rescue Errno::EPIPE => e
+          STDOUT.puts "GUI not listening, exit anyway."
+        end
+        continue = false
+      else
+        case message[:type]
+        when :incoming
+          gui.send("/incoming/osc", message[:time], message[:id], message[:address], message[:args])
+        when :multi_message
+          gui.send("/log/multi_message", message[:jobid], message[:thread_name].to_s, message[:runtime].to_s, message[:val].size, *message[:val].flatten)
+        when :midi_out_ports
+          gui.send("/midi/out-ports", message[:val])
+        when :midi_in_ports
+          gui.send("/midi/in-ports", message[:val])
+        when :info
+          gui.send("/log/info", message[:style] || 0, message[:val] || "")
+        when :syntax_error
+          desc = message[:val] || ""
+          line = message[:line] || -1
+          error_line = message[:error_line] || ""
+          desc = CGI.escapeHTML(desc)
+          gui.send("/syntax_error", message[:jobid], desc, error_line, line, line.to_s)
+        when :error
+          desc = message[:val] || ""
+          trace = message[:backtrace].join("\n")
+          line = message[:line] || -1
+          # TODO: Move this escaping to the Qt Client
+          desc = CGI.escapeHTML(desc)
+          trace = CGI.escapeHTML(trace)
+          # puts "sending: /error #{desc}, #{trace}"
+          gui.send("/error", message[:jobid], desc, trace, line)
+        when "replace-buffer"
+          buf_id = message[:buffer_id]
+          content = message[:val] || "Internal error within a fn calling replace-buffer without a :val payload"
+          line = message[:line] || 0
+          index = message[:index] || 0
+          first_line = message[:first_line] || 0
+          #          puts "replacing buffer #{buf_id}, #{content}"
+          gui.send("/buffer/replace", buf_id, content, line, index, first_line)
+        when "replace-buffer-idx"
+          buf_idx = message[:buffer_idx] || 0
+          content = message[:val] || "Internal error within a fn calling replace-buffer-idx without a :val payload"
+          line = message[:line] || 0
+          index = message[:index] || 0
+          first_line = message[:first_line] || 0
+          #          puts "replacing buffer #{buf_id}, #{content}"
+          gui.send("/buffer/replace-idx", buf_idx, content, line, index, first_line)
+        when "run-buffer-idx"
+          buf_idx = message[:buffer_idx] || 0
+          #          puts "running buffer #{buf_idx}"
+          gui.send("/buffer/run-idx", buf_idx)
+        when "replace-lines"
+          buf_id = message[:buffer_id]
+          content = message[:val] || "Internal error within a fn calling replace-line without a :val payload"
+          point_line = message[:point_line] || 0
+          point_index = message[:point_index] || 0
+          start_line = message[:start_line] || point_line
+          finish_line = message[:finish_line] || start_line
+          #          puts "replacing line #{buf_id}, #{content}"
+          gui.send("/buffer/replace-lines", buf_id, content, start_line, finish_line, point_line, point_index)
+        when :version
+          v = message[:version]
+          v_num = message[:version_num]
+          lv = message[:latest_version]
+          lv_num = message[:latest_version_num]
+          lc = message[:last_checked]
+          plat = host_platform_desc
+          gui.send("/version", v.to_s, v_num.to_i, lv.to_s, lv_num.to_i, lc.day, lc.month, lc.year, plat.to_s)
+        when :all_jobs_completed
+          gui.send("/runs/all-completed")
+        when :boot_phase
+          gui.send("/boot/phase", message[:val])
+        when :job
+          id = message[:job_id]
+          action = message[:action]
+          # do nothing for now
+        else
+          STDOUT.puts "ignoring #{message}"
+        end
+
+      end
+    rescue Exception => e
+      STDOUT.puts "Exception!"
+      STDOUT.puts e.message
+      STDOUT.puts e.backtrace.inspect
+    end
+  end
+end
+
 begin
   sp =  klass.new sonic_pi_ports, ws_out, user_methods
 
@@ -200,28 +302,81 @@ rescue Exception => e
   exit
 end
 
+# Decoded strings only come back frozen when they are short shared
+# copies, so copy those and hand every other string on as is rather
+# than duplicating whole buffers on each request
+unfrozen = lambda do |s|
+  s.frozen? ? s.dup : s
+end
+
 osc_server.add_method("/run-code") do |args|
   gui_id = args[0]
-  code = args[1].force_encoding("utf-8")
+  code = unfrozen.call(args[1])
   sp.__spider_eval code
 end
 
+# Large buffers reach us as chunked transfers, see
+# SonicPi::OSC::UDPServer#handle_chunk
+if osc_server.respond_to?(:on_transfer)
+  osc_server.on_transfer do |id, ok|
+    gui.send("/chunk/ack", id, ok ? 1 : 0)
+  end
+end
+
+# The code of the last run of each buffer, which the GUI may send later
+# runs as changes against
+last_run_code = {}
+
 osc_server.add_method("/save-and-run-buffer") do |args|
   gui_id = args[0]
   buffer_id = args[1]
-  code = args[2].force_encoding("utf-8")
+  code = unfrozen.call(args[2])
   workspace = args[3]
+  last_run_code[buffer_id] = code
   sp.__save_buffer(buffer_id, code)
   sp.__spider_eval code, {workspace: workspace}
 end
 
+osc_server.add_method("/save-and-run-buffer-delta") do |args|
+  gui_id = args[0]
+  buffer_id = args[1]
+  base_checksum = args[2] & 0xffffffff
+  start_line = args[3]
+  finish_line = args[4]
+  replacement = unfrozen.call(args[5])
+  workspace = args[6]
+  run_checksum = args[7]
+  base = last_run_code[buffer_id]
+  if base && Zlib.crc32(base) == base_checksum
+    lines = base.lines
+    code = (lines[0...start_line] + [replacement] + (lines[finish_line..-1] || [])).join
+    last_run_code[buffer_id] = code
+    sp.__save_buffer(buffer_id, code)
+    sp.__spider_eval code, {workspace: workspace}
+  else
+    # we don't have the code the changes were made against, so ask the
+    # GUI for the whole buffer. The checksum of the code it was trying
+    # to run lets it ignore this if it has run the buffer again since.
+    gui.send("/buffer/delta-failed", buffer_id, run_checksum)
+  end
+end
+
 osc_server.add_method("/save-buffer") do |args|
   gui_id = args[0]
   buffer_id = args[1]
-  code = args[2].force_encoding("utf-8")
+  code = unfrozen.call(args[2])
   sp.__save_buffer(buffer_id, code)
 end
 
+osc_server.add_method("/save-buffers") do |args|
+  gui_id = args[0]
+  buffers = {}
+  args[1..-1].each_slice(2) do |buffer_id, code|
+    buffers[buffer_id] = unfrozen.call(code)
+  end
+  sp.__save_buffers(buffers)
+end
+
 osc_server.add_method("/exit") do |args|
   gui_id = args[0]
   sp.__exit
@@ -240,7 +395,7 @@ end
 osc_server.add_method("/buffer-newline-and-indent") do |args|
   gui_id = args[0]
   id = args[1]
-  buf = args[2].force_encoding("utf-8")
+  buf = unfrozen.call(args[2])
   point_line = args[3]
   point_index = args[4]
   first_line = args[5]
@@ -250,7 +405,7 @@ end
 osc_server.add_method("/buffer-section-complete-snippet-or-indent-selection") do |args|
   gui_id = args[0]
   id = args[1]
-  buf = args[2].force_encoding("utf-8")
+  buf = unfrozen.call(args[2])
   start_line = args[3]
   finish_line = args[4]
   point_line = args[5]
@@ -261,7 +416,7 @@ end
 osc_server.add_method("/buffer-indent-selection") do |args|
   gui_id = args[0]
   id = args[1]
-  buf = args[2].force_encoding("utf-8")
+  buf = unfrozen.call(args[2])
   start_line = args[3]
   finish_line = args[4]
   point_line = args[5]
@@ -272,7 +427,7 @@ end
 osc_server.add_method("/buffer-section-toggle-comment") do |args|
   gui_id = args[0]
   id = args[1]
-  buf = args[2].force_encoding("utf-8")
+  buf = unfrozen.call(args[2])
   start_line = args[3]
   finish_line = args[4]
   point_line = args[5]
@@ -283,7 +438,7 @@ end
 osc_server.add_method("/buffer-beautify") do |args|
   gui_id = args[0]
   id = args[1]
-  buf = args[2].force_encoding("utf-8")
+  buf = unfrozen.call(args[2])
   line = args[3]
   index = args[4]
   first_line = args[5]
@@ -435,106 +590,9 @@ osc_server.add_method("/osc-port-stop") do |args|
   sp.__stop_cue_server!(silent)
 end
 
-# Send stuff out from Sonic Pi back out to osc_server
-out_t = Thread.new do
-  continue = true
-  while continue
-    begin
-      message = ws_out.pop
-      # message[:ts] = Time.now.strftime("%H:%M:%S")
-
-      if message[:type] == :exit
-        begin
-          gui.send("/exited")
-        rescue Errno::EPIPE => e
-          STDOUT.puts "GUI not listening, exit anyway."
-        end
-        continue = false
-      else
-        case message[:type]
-        when :incoming
-          gui.send("/incoming/osc", message[:time], message[:id], message[:address], message[:args])
-        when :multi_message
-          gui.send("/log/multi_message", message[:jobid], message[:thread_name].to_s, message[:runtime].to_s, message[:val].size, *message[:val].flatten)
-        when :midi_out_ports
-          gui.send("/midi/out-ports", message[:val])
-        when :midi_in_ports
-          gui.send("/midi/in-ports", message[:val])
-        when :info
-          gui.send("/log/info", message[:style] || 0, message[:val] || "")
-        when :syntax_error
-          desc = message[:val] || ""
-          line = message[:line] || -1
-          error_line = message[:error_line] || ""
-          desc = CGI.escapeHTML(desc)
-          gui.send("/syntax_error", message[:jobid], desc, error_line, line, line.to_s)
-        when :error
-          desc = message[:val] || ""
-          trace = message[:backtrace].join("\n")
-          line = message[:line] || -1
-          # TODO: Move this escaping to the Qt Client
-          desc = CGI.escapeHTML(desc)
-          trace = CGI.escapeHTML(trace)
-          # puts "sending: /error #{desc}, #{trace}"
-          gui.send("/error", message[:jobid], desc, trace, line)
-        when "replace-buffer"
-          buf_id = message[:buffer_id]
-          content = message[:val] || "Internal error within a fn calling replace-buffer without a :val payload"
-          line = message[:line] || 0
-          index = message[:index] || 0
-          first_line = message[:first_line] || 0
-          #          puts "replacing buffer #{buf_id}, #{content}"
-          gui.send("/buffer/replace", buf_id, content, line, index, first_line)
-        when "replace-buffer-idx"
-          buf_idx = message[:buffer_idx] || 0
-          content = message[:val] || "Internal error within a fn calling replace-buffer-idx without a :val payload"
-          line = message[:line] || 0
-          index = message[:index] || 0
-          first_line = message[:first_line] || 0
-          #          puts "replacing buffer #{buf_id}, #{content}"
-          gui.send("/buffer/replace-idx", buf_idx, content, line, index, first_line)
-        when "run-buffer-idx"
-          buf_idx = message[:buffer_idx] || 0
-          #          puts "running buffer #{buf_idx}"
-          gui.send("/buffer/run-idx", buf_idx)
-        when "replace-lines"
-          buf_id = message[:buffer_id]
-          content = message[:val] || "Internal error within a fn calling replace-line without a :val payload"
-          point_line = message[:point_line] || 0
-          point_index = message[:point_index] || 0
-          start_line = message[:start_line] || point_line
-          finish_line = message[:finish_line] || start_line
-          #          puts "replacing line #{buf_id}, #{content}"
-          gui.send("/buffer/replace-lines", buf_id, content, start_line, finish_line, point_line, point_index)
-        when :version
-          v = message[:version]
-          v_num = message[:version_num]
-          lv = message[:latest_version]
-          lv_num = message[:latest_version_num]
-          lc = message[:last_checked]
-          plat = host_platform_desc
-          gui.send("/version", v.to_s, v_num.to_i, lv.to_s, lv_num.to_i, lc.day, lc.month, lc.year, plat.to_s)
-        when :all_jobs_completed
-          gui.send("/runs/all-completed")
-        when :job
-          id = message[:job_id]
-          action = message[:action]
-          # do nothing for now
-        else
-          STDOUT.puts "ignoring #{message}"
-        end
-
-      end
-    rescue Exception => e
-      STDOUT.puts "Exception!"
-      STDOUT.puts e.message
-      STDOUT.puts e.backtrace.inspect
-    end
-  end
-end
-
 puts "This is Sonic Pi #{sp.__current_version} running on #{os} with ruby api #{RbConfig::CONFIG['ruby_version']}."
 puts "Sonic Pi Server successfully booted."
+ws_out.push({:type => :boot_phase, :val => "ready"})
 
 STDOUT.flush
 
@@ -37,8 +37,10 @@ module SonicPi
         args_h[:amp] = a.to_f / s if a && s > 0
         args_h.delete(:notes)
         r_notes = notes.ring
-        @sub_nodes.each_with_index do |sn, idx|
-          sn.control(args_h.merge({:note => r_notes[idx]}))
+        @comms.with_batched_osc do
+          @sub_nodes.each_with_index do |sn, idx|
+            sn.control(args_h.merge({:note => r_notes[idx]}))
+          end
         end
       else
         super
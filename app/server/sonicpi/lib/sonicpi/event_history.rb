@@ -40,7 +40,44 @@ module SonicPi
     attr_reader :handle, :prom, :ce
 
     def initialize(ce, val_matcher=nil, handle=nil, prom=nil)
-      path = String.new(ce.path)
+      if defined?(FastOsc::Pattern)
+        # parsed once in C so matching each cue against a waiting
+        # sync is a quick walk over the path rather than a regexp
+        @matcher = FastOsc::Pattern.new(ce.path)
+      else
+        @matcher = path_regexp(ce.path)
+      end
+
+      @val_matcher = val_matcher
+      @alive = true
+      @prom = prom
+      @handle = handle
+      @ce = ce
+    end
+
+    def kill
+      @alive = false
+    end
+
+    def dead?
+      !@alive
+    end
+
+    def path_match(path, val=:sonic_pi_no_match_val)
+      return nil unless @matcher === path
+
+      if @val_matcher && (val != :sonic_pi_no_match_val)
+        safe_matcher_call(@val_matcher, val)
+      else
+        true
+      end
+    end
+
+    private
+
+    # Used when the fast_osc extension isn't available
+    def path_regexp(path)
+      path = String.new(path)
 
       # get rid of white space
       path.strip!
@@ -78,30 +115,7 @@ module SonicPi
       # convert to a regexp
       matcher_str = "\\A/?#{path}/?\\Z"
 
-      @matcher = Regexp.new(matcher_str)
-
-      @val_matcher = val_matcher
-      @alive = true
-      @prom = prom
-      @handle = handle
-      @ce = ce
-    end
-
-    def kill
-      @alive = false
-    end
-
-    def dead?
-      !@alive
-    end
-
-    def path_match(path, val=:sonic_pi_no_match_val)
-
-      if @val_matcher && (val != :sonic_pi_no_match_val)
-        @matcher.match(path) && safe_matcher_call(@val_matcher, val)
-      else
-        @matcher.match(path)
-      end
+      Regexp.new(matcher_str)
     end
   end
 
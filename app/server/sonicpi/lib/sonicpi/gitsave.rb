@@ -33,23 +33,33 @@ module SonicPi
     end
 
     def save!(filename, content, msgpre="")
-      oid = @repo.write(content, :blob)
+      save_all!({filename => content}, msgpre)
+    end
+
+    # Commits all of the given filename => content pairs at once. Nothing
+    # is committed if none of them differ from what is already in HEAD.
+    def save_all!(files, msgpre="")
       index = @repo.index
       index.reload
-      index.add(:path => filename, :oid => oid, :mode => 0100644)
+      files.each do |filename, content|
+        oid = @repo.write(content, :blob)
+        index.add(:path => filename, :oid => oid, :mode => 0100644)
+      end
 
       options = {}
       options[:tree] = index.write_tree(@repo)
+      parent = @repo.empty? ? nil : @repo.head.target
+      return nil if parent && parent.tree_id == options[:tree]
 
+      names = files.keys.join(", ")
       options[:author] = { :email => "autosave@sonic-pi.net", :name => 'Sonic Pi Autosave', :time => Time.now }
       options[:committer] = { :email => "autosave@sonic-pi.net", :name => 'Sonic Pi Autosave', :time => Time.now }
-      options[:message] ||= "#{msgpre} :~: Autosave Workspace #{filename}"
-      options[:parents] = @repo.empty? ? [] : [ @repo.head.target ].compact
+      options[:message] ||= "#{msgpre} :~: Autosave Workspace#{files.size > 1 ? 's' : ''} #{names}"
+      options[:parents] = [ parent ].compact
       options[:update_ref] = 'HEAD'
 
       Rugged::Commit.create(@repo, options)
     end
 
-
   end
 end
@@ -4386,10 +4386,13 @@ Also, if you wish your synth to work with Sonic Pi's automatic stereo sound infr
 
         nodes = []
 
-        notes.each do |note|
-          if note
-            args_h[:note] = note
-            nodes << trigger_synth(synth_name, args_h, cg, info)
+        # send all the notes to scsynth in a single bundle
+        @mod_sound_studio.with_batched_osc do
+          notes.each do |note|
+            if note
+              args_h[:note] = note
+              nodes << trigger_synth(synth_name, args_h, cg, info)
+            end
           end
         end
         cg.sub_nodes = nodes
@@ -36,6 +36,7 @@ module SonicPi
         @low_g = 'g'.freeze
         @q_lt = 'q>'.freeze
         @binary_encoding = "BINARY".freeze
+        @utf8_encoding = "UTF-8".freeze
       end
 
       def decode_single_message(m)
@@ -96,6 +97,8 @@ module SonicPi
               orig_idx = idx
               idx = m.index(@string_terminator, orig_idx)
               arg, idx =  m[orig_idx...idx], idx + 1 + ((4 - ((idx + 1) % 4)) % 4)
+              # same as the C extension hands back
+              arg.force_encoding(@utf8_encoding)
             when @d_tag
               # double64
               arg, idx = m[idx, 8].unpack(@cap_g)[0], idx + 8
@@ -120,6 +123,37 @@ module SonicPi
         return address, args
       end
 
+      def decode_packet(m, time=nil, depth=0)
+        m.force_encoding(@binary_encoding)
+        unless m.start_with?("#bundle\0")
+          # malformed messages are dropped, as by the C extension
+          begin
+            return [[time, *decode_single_message(m)]]
+          rescue StandardError
+            return []
+          end
+        end
+
+        res = []
+        # elements are all a multiple of 4 bytes, as the C extension checks
+        return res if depth > 16 || m.bytesize < 16 || m.bytesize % 4 != 0
+        secs, frac = m[8, 8].unpack("NN")
+        # an immediate time tag inside a bundle means the bundle's own time
+        unless secs == 0 && frac == 1
+          time = Time.at(secs - 2208988800, (frac * 1000000) >> 32)
+        end
+
+        idx = 16
+        while idx + 4 <= m.bytesize
+          size = m[idx, 4].unpack(@cap_n)[0]
+          idx += 4
+          break if size == 0 || idx + size > m.bytesize
+          res.concat(decode_packet(m[idx, size], time, depth + 1)) if size % 4 == 0
+          idx += size
+        end
+        res
+      end
+
     end
   end
 end
@@ -43,6 +43,8 @@ module SonicPi
         @num_cached_strings = 0
 
         @bundle_header = get_from_or_add_to_string_cache("#bundle")
+        # the special time tag meaning "immediately", used for a nil time
+        @immediate_time = [0, 1].pack(@literal_cap_n2).freeze
       end
 
       def encode_single_message(address, args=[])
@@ -111,6 +113,15 @@ module SonicPi
         "#{@bundle_header}#{time_encoded(ts)}#{message_encoded}"
       end
 
+      def encode_bundle(ts, messages)
+        bundle = "#{@bundle_header}#{time_encoded(ts)}"
+        messages.each do |address, args|
+          message = encode_single_message(address, args || [])
+          bundle << [message.bytesize].pack(@literal_cap_n) << message
+        end
+        bundle
+      end
+
       private
       def get_from_or_add_to_string_cache(s)
         if cached = @string_cache[s]
@@ -132,6 +143,7 @@ module SonicPi
       end
 
       def time_encoded(time)
+        return @immediate_time if time.nil?
         t1, fr = (time.to_f + @literal_magic_time_offset).divmod(1)
 
         t2 = (fr * @literal_two_to_pow_2).to_i
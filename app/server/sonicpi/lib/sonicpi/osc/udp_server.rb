@@ -11,6 +11,7 @@
 # notice is included.
 #++
 require 'socket'
+require 'zlib'
 require_relative "../util"
 
 module SonicPi
@@ -18,6 +19,18 @@ module SonicPi
     class UDPServer
       include Util
 
+      # Limits on chunked transfers. Each fragment is a single datagram,
+      # so capping the number of fragments caps the reassembled size too.
+      MAX_TRANSFER_CHUNKS = 256
+      MAX_TRANSFERS_IN_FLIGHT = 8
+
+      # Limits on messages held back for their time stamps, so that
+      # anyone who can reach an open port can't fill up memory. Messages
+      # stamped further ahead than this many seconds are dropped, as are
+      # any arriving when the queue is full.
+      MAX_SCHEDULE_AHEAD = 300
+      MAX_SCHEDULED = 10_000
+
       def initialize(port, opts={}, &global_method)
         open = opts[:open]
         @port = port
@@ -30,8 +43,20 @@ module SonicPi
         end
         @matchers = {}
         @global_matcher = global_method
+        @transfer_handler = nil
+        @transfers = {}
+        @completed_transfers = {}
         @decoder = FastOsc
         @encoder = FastOsc
+        # messages in bundles time stamped for the future are held back
+        # until then when scheduling, each entry being
+        # [time, seq, address, args] kept sorted by time then arrival
+        @schedule = opts[:schedule]
+        @scheduled = []
+        @scheduled_seq = 0
+        @scheduled_mut = Mutex.new
+        @scheduled_cv = ConditionVariable.new
+        @scheduler_thread = Thread.new {start_scheduler} if @schedule
         @listener_thread = Thread.new {start_listener}
       end
 
@@ -45,20 +70,40 @@ module SonicPi
         @socket.send(msg, 0, address, port)
       end
 
+      # Sends all the messages, each a [pattern, args] pair, in a
+      # single bundle with time stamp ts
+      def send_bundle(ts, address, port, messages)
+        msg = @encoder.encode_bundle(ts, messages)
+        @socket.send(msg, 0, address, port)
+      end
+
       def add_method(address_pattern, &proc)
         @matchers[address_pattern] = proc
       end
 
+      # The global method is called with the address, args and the time
+      # the message is for. This is the time from its bundle's time tag
+      # for messages scheduled in the future, otherwise the time it
+      # arrived.
       def add_global_method(&proc)
         @global_matcher = proc
       end
 
+      # Called with the transfer id and whether its checksum matched each
+      # time a chunked transfer has been reassembled. Only servers with a
+      # handler, that is the one the GUI talks to, reassemble transfers;
+      # elsewhere /chunk is passed on like any other message.
+      def on_transfer(&proc)
+        @transfer_handler = proc
+      end
+
       def to_s
         "#<SonicPi::OSC::UDPServer port: #{@port}, opts: #{@opts.inspect}>"
       end
 
       def stop
         @listener_thread.kill
+        @scheduler_thread.kill if @scheduler_thread
         @socket.close
       end
 
@@ -82,22 +127,117 @@ module SonicPi
             redo
           end
 
-          begin
-            address, args = @decoder.decode_single_message(osc_data)
-            log "OSC <-----        #{address} #{args.inspect}" if incoming_osc_debug_mode
-            if @global_matcher
-              @global_matcher.call(address, args)
-            else
-              p = @matchers[address]
-              p.call(args) if p
+          dispatch(osc_data)
+        end
+      end
+
+      def dispatch(osc_data)
+        begin
+          messages = @decoder.decode_packet(osc_data)
+        rescue Exception => e
+          STDERR.puts "OSC unable to decode packet"
+          STDERR.puts e.message
+          STDERR.puts e.backtrace.inspect
+          return
+        end
+
+        # The GUI sends messages which queued up together as one bundle
+        # with an immediate time tag, so those are handled in turn
+        # straight away, as are any which are already due
+        now = Time.now
+        messages.each do |time, address, args|
+          if @schedule && time && time > now
+            schedule(time, address, args)
+          else
+            handle_message(address, args, now)
+          end
+        end
+      end
+
+      def handle_message(address, args, time)
+        begin
+          return handle_chunk(*args) if @transfer_handler && address == "/chunk"
+          log "OSC <-----        #{address} #{args.inspect}" if incoming_osc_debug_mode
+          if @global_matcher
+            @global_matcher.call(address, args, time)
+          else
+            p = @matchers[address]
+            p.call(args) if p
+          end
+        rescue Exception => e
+          STDERR.puts "OSC handler exception for address: #{address}"
+          STDERR.puts e.message
+          STDERR.puts e.backtrace.inspect
+        end
+      end
+
+      def schedule(time, address, args)
+        return if time - Time.now > MAX_SCHEDULE_AHEAD
+        @scheduled_mut.synchronize do
+          return if @scheduled.size >= MAX_SCHEDULED
+          entry = [time, @scheduled_seq += 1, address, args]
+          idx = @scheduled.bsearch_index { |e| (e[0] <=> time) > 0 } || @scheduled.size
+          @scheduled.insert(idx, entry)
+          # only the earliest message changes how long to wait
+          @scheduled_cv.signal if idx == 0
+        end
+      end
+
+      def start_scheduler
+        Kernel.loop do
+          due = []
+          @scheduled_mut.synchronize do
+            Kernel.loop do
+              if @scheduled.empty?
+                @scheduled_cv.wait(@scheduled_mut)
+              else
+                delay = @scheduled[0][0] - Time.now
+                break if delay <= 0
+                @scheduled_cv.wait(@scheduled_mut, delay)
+              end
             end
-          rescue Exception => e
-            STDERR.puts "OSC handler exception for address: #{address}"
-            STDERR.puts e.message
-            STDERR.puts e.backtrace.inspect
+            now = Time.now
+            due << @scheduled.shift while !@scheduled.empty? && @scheduled[0][0] <= now
+          end
+          due.each do |time, _, address, args|
+            handle_message(address, args, time)
           end
         end
       end
+
+      # Packets too big for one datagram arrive as numbered fragments
+      # with a CRC32 of the whole packet. Once every fragment is here the
+      # packet is checked, acknowledged and handled like any other.
+      def handle_chunk(id, idx, count, checksum, data)
+        now = Time.now
+        @transfers.delete_if { |_, t| now - t[:started] > 30 }
+        @completed_transfers.delete_if { |_, t| now - t > 60 }
+
+        if @completed_transfers[id]
+          # our ack was lost and the sender is trying again
+          @transfer_handler.call(id, true) if @transfer_handler
+          return
+        end
+
+        return unless count.is_a?(Integer) && idx.is_a?(Integer) && data.is_a?(String)
+        return if count > MAX_TRANSFER_CHUNKS || idx < 0 || idx >= count
+        # the sender tries again later if this one is refused
+        return if !@transfers[id] && @transfers.size >= MAX_TRANSFERS_IN_FLIGHT
+        t = (@transfers[id] ||= { parts: Array.new(count), received: 0, started: now })
+        return unless t[:parts].size == count
+        unless t[:parts][idx]
+          t[:parts][idx] = data
+          t[:received] += 1
+        end
+        return unless t[:received] == count
+
+        @transfers.delete(id)
+        packet = t[:parts].join
+        ok = Zlib.crc32(packet) == (checksum & 0xffffffff)
+        @completed_transfers[id] = now if ok
+        @transfer_handler.call(id, ok) if @transfer_handler
+        dispatch(packet) if ok
+      end
     end
   end
 end
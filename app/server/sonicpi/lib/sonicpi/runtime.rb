@@ -101,14 +101,16 @@ module SonicPi
       @osc_cue_server_mutex.synchronize do
         @osc_server.stop if @osc_server
         __info "Restarting OSC server...." unless silent
-        @osc_server = SonicPi::OSC::UDPServer.new(@osc_cues_port, open: open,) do |address, args|
+        # Messages in time stamped bundles, such as from a DAW, are held
+        # until their time comes and then cued at exactly that time
+        @osc_server = SonicPi::OSC::UDPServer.new(@osc_cues_port, open: open, schedule: true) do |address, args, time|
           address = "/#{address}" unless address.start_with?("/")
           address = "/osc#{address}"
           p = 0
           d = 0
           b = 0
           m = 60
-          @register_cue_event_lambda.call(Time.now, p, @system_init_thread_id, d, b, m, address, args, 0)
+          @register_cue_event_lambda.call(time, p, @system_init_thread_id, d, b, m, address, args, 0)
         end
 
         unless silent
@@ -708,7 +710,11 @@ module SonicPi
     end
 
     def __save_buffer(id, content)
-      @save_queue << [id, content]
+      @save_queue << {id => content}
+    end
+
+    def __save_buffers(buffers)
+      @save_queue << buffers unless buffers.empty?
     end
 
     def __disable_update_checker
@@ -1149,16 +1155,31 @@ module SonicPi
       @save_t = Thread.new do
         __system_thread_locals.set_local(:sonic_pi_local_thread_group, :save_loop)
         Kernel.loop do
-          event = @save_queue.pop
-          id, content = *event
-          filename = id + '.spi'
-          path = project_path + "/" + filename
-          content = filter_for_save(content)
+          buffers = @save_queue.pop
+          # fold in any saves which queued up meanwhile so they all go
+          # into a single commit, the latest content of a buffer winning
+          begin
+            loop { buffers = buffers.merge(@save_queue.pop(true)) }
+          rescue ThreadError
+          end
+
+          files = {}
+          buffers.each do |id, content|
+            filename = id + '.spi'
+            path = project_path + "/" + filename
+            content = filter_for_save(content)
+            begin
+              File.open(path, 'w') {|f| f.write(content) }
+              files[filename] = content
+            rescue Exception => e
+              log "Exception saving buffer #{filename}:\n#{e.inspect}"
+            end
+          end
+
           begin
-            File.open(path, 'w') {|f| f.write(content) }
-            @gitsave.save!(filename, content, "#{@version} -- #{@session_id} -- ")
+            @gitsave.save_all!(files, "#{@version} -- #{@session_id} -- ") if @gitsave && !files.empty?
           rescue Exception => e
-            log "Exception saving buffer #{filename}:\n#{e.inspect}"
+            log "Exception committing buffers #{files.keys.join(', ')}:\n#{e.inspect}"
             ##TODO: remove this and ensure that git saving actually works
             ##instead of cowardly hiding the issue!
           end
@@ -45,6 +45,10 @@ module SonicPi
     def send(*all_args)
       address, *args = *all_args
       log "OSC             ~ #{address} #{args.inspect}" if osc_debug_mode
+      # anything held back by batch_sends was sent first, so keep it so
+      if pending = __system_thread_locals.get(:sonic_pi_local_scsynth_pending_bundles)
+        send_pending_bundles(pending)
+      end
       @osc_server.send(@hostname, @send_port, address, *args)
     end
 
@@ -62,7 +66,31 @@ module SonicPi
         log "BDL #{'%11.5f' % vt} ~ [#{vt}:#{ts.to_f}] #{address} #{args.inspect}"
       end
 
-      @osc_server.send_ts(ts, @hostname, @send_port, address, *args)
+      if pending = __system_thread_locals.get(:sonic_pi_local_scsynth_pending_bundles)
+        (pending[ts] ||= []) << [address, args]
+      else
+        @osc_server.send_ts(ts, @hostname, @send_port, address, *args)
+      end
+    end
+
+    # Holds back the messages this thread sends with send_at whilst the
+    # block runs, then sends those sharing a time stamp as one bundle
+    # so scsynth gets a single packet and schedules them together. As
+    # scsynth runs bundles in time order, and in arrival order for the
+    # same time, grouping by time stamp doesn't change what it does.
+    # Sending a message straight away from within the block sends what
+    # has been held back so far first, so the order of sends is kept.
+    def batch_sends(&blk)
+      return blk.call if __system_thread_locals.get(:sonic_pi_local_scsynth_pending_bundles)
+
+      pending = {}
+      __system_thread_locals.set_local(:sonic_pi_local_scsynth_pending_bundles, pending)
+      begin
+        blk.call
+      ensure
+        __system_thread_locals.set_local(:sonic_pi_local_scsynth_pending_bundles, nil)
+        send_pending_bundles(pending)
+      end
     end
 
     def reboot
@@ -97,6 +125,15 @@ module SonicPi
 
     private
 
+    # Sends the messages held back by batch_sends, one bundle per time
+    # stamp, and empties the hash
+    def send_pending_bundles(pending)
+      pending.each do |ts, messages|
+        @osc_server.send_bundle(ts, @hostname, @send_port, messages)
+      end
+      pending.clear
+    end
+
     def request_version
       version_string = `'#{scsynth_path}' -v`
       m = version_string.match /\A\s*scsynth\s+([0-9.]+)\s.*/
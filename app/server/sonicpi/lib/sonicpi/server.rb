@@ -643,6 +643,10 @@ module SonicPi
       @scsynth.send_at(ts, *args)
     end
 
+    def with_batched_osc(&blk)
+      @scsynth.batch_sends(&blk)
+    end
+
     def async_add_event_handlers(*args)
       @osc_events.async_add_handlers(*args)
     end
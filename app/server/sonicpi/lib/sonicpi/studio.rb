@@ -54,9 +54,12 @@ module SonicPi
       @midi_in_ports = []
       @midi_out_ports = []
       init_scsynth
+      boot_phase "scsynth"
       reset_server
       init_studio
+      boot_phase "synthdefs"
       start_erlang
+      boot_phase "erlang"
       init_or_reset_midi
     end
 
@@ -346,6 +349,10 @@ module SonicPi
       @server.trigger_live_synth(name_id, pos, group, synth_name, args, info, now, t_minus_delta, pre_trig, on_move_blk)
     end
 
+    def with_batched_osc(&blk)
+      @server.with_batched_osc(&blk)
+    end
+
     def trigger_synth(synth_name, group, args, info, now=false, t_minus_delta=false, pos=:tail )
       check_for_server_rebooting!(:trigger_synth)
 
@@ -603,6 +610,10 @@ module SonicPi
       log s
     end
 
+    def boot_phase(phase)
+      @msg_queue.push({:type => :boot_phase, :val => phase})
+    end
+
     def message(s)
       m = s.to_s
       @msg_queue.push({:type => :info, :val => m}) unless __system_thread_locals.get :sonic_pi_spider_silent
@@ -42,6 +42,36 @@ if ENV['RUN_PERF_TESTS']
     bencher.compare
   end
 
+  # a typical synth trigger, and one with more args than fast_osc
+  # encodes using the stack alone
+  s_new_args = ["sonic-pi-beep", 1001, 0, 2, :note, 60.0, :amp, 1.0, :release, 0.5, :pan, 0.0, "out_bus", 12.0]
+  long_args = (s_new_args * 6).take(80)
+  big_args = ["x" * 65536]
+
+  puts "SYNTH ENCODING TEST"
+  Benchmark.ips do |bencher|
+    bencher.report("fast_osc s_new") { FastOsc.encode_single_message("/s_new", s_new_args) }
+    bencher.report("samsosc s_new") { samoscenc.encode_single_message("/s_new", s_new_args) }
+    bencher.report("fast_osc 80 args") { FastOsc.encode_single_message("/s_new", long_args) }
+    bencher.report("samsosc 80 args") { samoscenc.encode_single_message("/s_new", long_args) }
+    bencher.report("fast_osc 64k string") { FastOsc.encode_single_message("/big", big_args) }
+    bencher.report("samsosc 64k string") { samoscenc.encode_single_message("/big", big_args) }
+
+    bencher.compare
+  end
+
+  chord = [60, 64, 67, 71].map { |n| ["/s_new", s_new_args + [:note, n]] }
+  ts = Time.now
+
+  puts "BUNDLE ENCODING TEST"
+  Benchmark.ips do |bencher|
+    bencher.report("fast_osc bundle per note") { chord.each { |path, args| FastOsc.encode_single_bundle(ts, path, args) } }
+    bencher.report("fast_osc one bundle") { FastOsc.encode_bundle(ts, chord) }
+    bencher.report("samsosc one bundle") { samoscenc.encode_bundle(ts, chord) }
+
+    bencher.compare
+  end
+
   # puts samosc.decode_single_message(test_message).inspect
   puts "DECODING TEST"
   Benchmark.ips do |bencher|
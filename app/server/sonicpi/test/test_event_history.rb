@@ -596,6 +596,31 @@ module SonicPi
       assert_nil  m.path_match("/push40", nil)
     end
 
+    def test_event_matcher_native_pattern_agrees_with_regexp
+      skip "fast_osc extension not loaded" unless defined?(FastOsc::Pattern)
+
+      m = EventMatcher.new(make_cue_event("/foo"), nil, ThreadId.new(5), Promise.new)
+      patterns = ["/foo/bar", "/foo*/*/*baz", "/foo/**/baz", "/foo/**", "/*/*",
+                  "/{cue,set}/[a-c]az", "/?ue/{baz,boz}/quux[!12]", "/[cue/caz]",
+                  "/{cue/caz}", " /cue/foo ", "/**/baz", "/" + "*a" * 8 + "*b",
+                  "/*/***", "/foo/***/baz"]
+      paths = ["/foo/bar", "foo/bar/", "/foo/bar/baz", "/foo/bar/beans/baz", "/foo",
+               "/foo//baz", "/cue/baz", "/set/daz", "/due/boz/quux3", "/cue/boz/quux12",
+               "/[cue/caz]/", "/{cue/caz}", "/cue/foo", "/baz", "/bar/baz", "/", "",
+               "/" + "a" * 30, "/" + "a" * 30 + "b", "/c/b/b", "/c/b"]
+
+      started = Time.now
+      patterns.each do |pattern|
+        regexp = m.send(:path_regexp, pattern)
+        native = FastOsc::Pattern.new(pattern)
+        paths.each do |path|
+          assert_equal !!regexp.match(path), native.match?(path), "#{pattern.inspect} against #{path.inspect}"
+        end
+      end
+      # stars mustn't make matching blow up, as the server waits on it
+      assert_operator Time.now - started, :<, 1
+    end
+
     def test_foo
       history = EventHistory.new
       i1 = ThreadId.new(0, 0)
@@ -45,5 +45,149 @@ module SonicPi
         assert_equal(args, d_args)
       end
     end
+
+    def test_decode_shares_frozen_addresses_and_short_strings
+      skip "fast_osc extension not loaded" unless defined?(FastOsc::NATIVE)
+      m = FastOsc.encode_single_message("/n_go", ["amp", "a" * 100])
+      address1, args1 = FastOsc.decode_single_message(m)
+      address2, args2 = FastOsc.decode_single_message(m)
+
+      assert(address1.frozen?)
+      assert_same(address1, address2)
+      assert_same(args1[0], args2[0])
+      assert_equal(Encoding::UTF_8, args1[0].encoding)
+      # long strings are left alone
+      refute(args1[1].frozen?)
+    end
+
+    def test_udp_server_dispatches_bundle_elements_in_order
+      received = Queue.new
+      server = SonicPi::OSC::UDPServer.new(47123)
+      server.add_method("/a") { |args| received << ["/a", args] }
+      server.add_method("/b") { |args| received << ["/b", args] }
+
+      m1 = FastOsc.encode_single_message("/a", [1, "x"])
+      m2 = FastOsc.encode_single_message("/b", [2.0])
+      # immediate time tag
+      bundle = "#bundle\0" + [0, 1].pack("NN") + [m1.bytesize].pack("N") + m1 + [m2.bytesize].pack("N") + m2
+
+      client = UDPSocket.new
+      client.send(bundle, 0, "127.0.0.1", 47123)
+      assert_equal(["/a", [1, "x"]], received.pop)
+      assert_equal(["/b", [2.0]], received.pop)
+    ensure
+      server.stop if server
+    end
+
+    def test_encode_bundle_with_multiple_messages
+      m1 = FastOsc.encode_single_message("/a", [1, "x"])
+      m2 = FastOsc.encode_single_message("/b", [2.0])
+      bundle = "#bundle\0" + [0, 1].pack("NN") + [m1.bytesize].pack("N") + m1 + [m2.bytesize].pack("N") + m2
+
+      assert_equal(bundle, FastOsc.encode_bundle(nil, [["/a", [1, "x"]], ["/b", [2.0]]]))
+
+      t = Time.at(1463234577.5)
+      assert_equal(FastOsc.encode_single_bundle(t, "/c", [3]), FastOsc.encode_bundle(t, [["/c", [3]]]))
+    end
+
+    def test_decode_packet_walks_nested_bundles
+      t = Time.at(2000000000.25)
+      m1 = FastOsc.encode_single_message("/a", [1, "x"])
+      m2 = FastOsc.encode_single_message("/b", [2.0])
+      inner = FastOsc.encode_bundle(t, [["/c", [3]]])
+      bundle = "#bundle\0" + [0, 1].pack("NN") + [m1, inner, m2].map { |m| [m.bytesize].pack("N") + m }.join
+
+      assert_equal([[nil, "/a", [1, "x"]], [t, "/c", [3]], [nil, "/b", [2.0]]], FastOsc.decode_packet(bundle))
+      assert_equal([[nil, "/a", [1, "x"]]], FastOsc.decode_packet(m1))
+      # truncated bundle elements are dropped
+      assert_equal([[nil, "/a", [1, "x"]]], FastOsc.decode_packet(bundle[0, 20 + m1.bytesize + 8]))
+      # as are malformed messages, whether alone or in a bundle
+      bad = "/foo\0\0\0\0,s\0\0"
+      assert_equal([], FastOsc.decode_packet(bad))
+      assert_equal([], FastOsc.decode_packet("garbage"))
+      bundle = "#bundle\0" + [0, 1].pack("NN") + [m1, bad].map { |m| [m.bytesize].pack("N") + m }.join
+      assert_equal([[nil, "/a", [1, "x"]]], FastOsc.decode_packet(bundle))
+    end
+
+    def test_udp_server_schedules_future_bundles
+      received = Queue.new
+      server = SonicPi::OSC::UDPServer.new(47125, schedule: true) do |address, args, time|
+        received << [address, time]
+      end
+
+      t = Time.now + 0.3
+      client = UDPSocket.new
+      # too far ahead to be held on to
+      client.send(FastOsc.encode_bundle(Time.now + 3600, [["/2100", []]]), 0, "127.0.0.1", 47125)
+      client.send(FastOsc.encode_bundle(t, [["/later", []]]), 0, "127.0.0.1", 47125)
+      client.send(FastOsc.encode_single_message("/now"), 0, "127.0.0.1", 47125)
+
+      address, time = received.pop
+      assert_equal("/now", address)
+      assert(time < t)
+      address, time = received.pop
+      assert_equal("/later", address)
+      assert_in_delta(t.to_f, time.to_f, 0.001)
+      assert(Time.now >= t)
+      assert(server.instance_variable_get(:@scheduled).empty?)
+    ensure
+      server.stop if server
+    end
+
+    def test_udp_server_reassembles_chunked_transfers
+      received = Queue.new
+      acks = Queue.new
+      server = SonicPi::OSC::UDPServer.new(47124)
+      server.add_method("/a") { |args| received << args }
+      server.on_transfer { |id, ok| acks << [id, ok] }
+
+      packet = FastOsc.encode_single_message("/a", ["x" * 1000])
+      crc = Zlib.crc32(packet)
+      crc -= 2**32 if crc >= 2**31
+      parts = [packet[0, 400], packet[400, 400], packet[800..-1]]
+
+      client = UDPSocket.new
+      # fragments may arrive in any order
+      [2, 0, 1].each do |i|
+        client.send(encode_chunk(7, i, 3, crc, parts[i]), 0, "127.0.0.1", 47124)
+      end
+      assert_equal([7, true], acks.pop)
+      assert_equal(["x" * 1000], received.pop)
+
+      client.send(encode_chunk(8, 0, 1, crc, packet[0..-2]), 0, "127.0.0.1", 47124)
+      assert_equal([8, false], acks.pop)
+      assert(received.empty?)
+
+      # too many fragments are refused without anything being allocated
+      client.send(encode_chunk(9, 0, 2**30, crc, packet), 0, "127.0.0.1", 47124)
+      client.send(encode_chunk(10, 0, 1, crc, packet), 0, "127.0.0.1", 47124)
+      assert_equal([10, true], acks.pop)
+      assert_equal(["x" * 1000], received.pop)
+    ensure
+      server.stop if server
+    end
+
+    def test_udp_server_without_transfer_handler_passes_chunks_on
+      received = Queue.new
+      server = SonicPi::OSC::UDPServer.new(47126) do |address, args, time|
+        received << [address, args]
+      end
+
+      client = UDPSocket.new
+      client.send(encode_chunk(1, 0, 2**30, 0, "cue"), 0, "127.0.0.1", 47126)
+      assert_equal(["/chunk", [1, 0, 2**30, 0, "cue"]], received.pop)
+    ensure
+      server.stop if server
+    end
+
+    private
+
+    # FastOsc can't encode blobs, so build the GUI's /chunk message by hand
+    def encode_chunk(id, idx, count, crc, data)
+      pad = lambda { |s| s + "\0" * (4 - s.bytesize % 4) }
+      blob = [data.bytesize].pack("N") + data
+      blob += "\0" * ((4 - blob.bytesize % 4) % 4)
+      pad.call("/chunk") + pad.call(",iiiib") + [id, idx, count, crc].pack("l>4") + blob
+    end
   end
 end
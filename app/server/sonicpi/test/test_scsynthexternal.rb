@@ -0,0 +1,73 @@
+#--
+# This file is part of Sonic Pi: http://sonic-pi.net
+# Full project source: https://github.com/samaaron/sonic-pi
+# License: https://github.com/samaaron/sonic-pi/blob/master/LICENSE.md
+#
+# Copyright 2013, 2014, 2015, 2016 by Sam Aaron (http://sam.aaron.name).
+# All rights reserved.
+#
+# Permission is granted for use, copying, modification, and
+# distribution of modified versions of this work as long as this
+# notice is included.
+#++
+
+require_relative "./setup_test"
+require_relative "../lib/sonicpi/scsynthexternal"
+
+module SonicPi
+  class SCSynthExternalTester < Minitest::Test
+    # Records what would have gone to scsynth
+    class RecordingServer
+      attr_reader :sent
+
+      def initialize
+        @sent = []
+      end
+
+      def send(hostname, port, address, *args)
+        @sent << [:message, address]
+      end
+
+      def send_ts(ts, hostname, port, address, *args)
+        @sent << [:bundle, ts, [address]]
+      end
+
+      def send_bundle(ts, hostname, port, messages)
+        @sent << [:bundle, ts, messages.map(&:first)]
+      end
+    end
+
+    def setup
+      # don't boot scsynth, just talk to the recorder
+      @scsynth = SCSynthExternal.allocate
+      @server = RecordingServer.new
+      @scsynth.instance_variable_set(:@osc_server, @server)
+    end
+
+    def test_batch_sends_groups_messages_by_time_stamp
+      @scsynth.batch_sends do
+        @scsynth.send_at(1, "/s_new", 1)
+        @scsynth.send_at(2, "/n_set", 1)
+        @scsynth.send_at(1, "/s_new", 2)
+      end
+
+      assert_equal([[:bundle, 1, ["/s_new", "/s_new"]], [:bundle, 2, ["/n_set"]]], @server.sent)
+    end
+
+    def test_batch_sends_keeps_immediate_sends_in_order
+      @scsynth.batch_sends do
+        @scsynth.send_at(1, "/s_new", 1)
+        @scsynth.send("/n_free", 1)
+        @scsynth.send_at(1, "/s_new", 2)
+      end
+
+      assert_equal([[:bundle, 1, ["/s_new"]], [:message, "/n_free"], [:bundle, 1, ["/s_new"]]], @server.sent)
+    end
+
+    def test_send_at_outside_batch_sends_straight_away
+      @scsynth.send_at(1, "/s_new", 1)
+
+      assert_equal([[:bundle, 1, ["/s_new"]]], @server.sent)
+    end
+  end
+end